@@ -6,14 +6,15 @@
 namespace Arawn {
     struct RenderMode {
         enum Enum : uint32_t {
-            FORWARD  = 0b0000'0000'0000'0000, 
-            DEFERRED = 0b0000'0000'0100'0000,
+            FORWARD    = 0b0000'0000'0000'0000'0000, 
+            DEFERRED   = 0b0000'0000'0000'0100'0000,
+            VISIBILITY = 0b0001'0000'0000'0000'0000, // triangle ids rasterised, materials and lights resolved per pixel
         };
-        static constexpr uint32_t MASK = 0b0000'0000'0100'0000; 
-        static constexpr const char* NAME = "deferred";
+        static constexpr uint32_t MASK = 0b0001'0000'0000'0100'0000; 
+        static constexpr const char* NAME = "render mode";
 
         RenderMode() = default;
-        RenderMode(Json::Boolean val);
+        RenderMode(Json::String val);
 
         uint32_t data = DEFERRED;
     };
@@ -23,9 +24,11 @@ namespace Arawn {
             DISABLED = 0b0000'0000'0000'0000, 
             TILE     = 0b0000'0000'1000'0000,
             CLUSTER  = 0b0000'0001'0000'0000,
+            ZBIN     = 0b0000'0001'1000'0000, // depth sorted lights, tile masks and z bin ranges
+            TILE_25D = 0b0000'0100'1000'0000, // tiles with a per tile depth slice occupancy mask
         };
 
-        static constexpr uint32_t MASK = 0b0000'0001'1000'0000;
+        static constexpr uint32_t MASK = 0b0000'0101'1000'0000;
         static constexpr const char* NAME = "culling mode";
 
         CullingMode() = default;
@@ -0,0 +1,63 @@
+#pragma once
+#include <graphics/engine.h>
+#include <graphics/renderer.h>
+#include <graphics/frustums.h>
+#include <graphics/pipelines.h>
+#include <graphics/resources/program.h>
+#include <functional>
+#include <vector>
+
+namespace Arawn {
+    // std430 layout of Light in the culling and shading shaders
+    struct Light {
+        float position[3];
+        float radius;
+        float colour[3];
+        float curve;
+    };
+
+    // clustered light culling declared as a graph task on the async compute queue. clustered mode reads no depth,
+    // so the culling of frame N+1 runs on the async queue while frame N shades on graphics. the light, cluster
+    // and light index buffers are graph outputs, the graph transfers their ownership to the shading family
+    class ClusterCulling {
+    public:
+        // binds the camera uniform holding proj and view to set 0 of the program, called from the culling task
+        using Camera = std::function<void(const Render::Task::Context&, const Program&)>;
+
+        // slices is the cluster count along depth, at most MAX_DEPTH_SLICES
+        ClusterCulling(FrustumGrid& grid, Pipelines& pipelines, uint32_t slices = 32, uint32_t capacity = MAX_LIGHTS);
+
+        ClusterCulling(const ClusterCulling&) = delete;
+        ClusterCulling& operator=(const ClusterCulling&) = delete;
+        ClusterCulling(ClusterCulling&&) = delete;
+        ClusterCulling& operator=(ClusterCulling&&) = delete;
+
+        // lights and projection culled from the next recorded frame on, the culling task copies them into the frame's light buffer
+        void update(const std::vector<Light>& lights, const float proj[16]);
+
+        // declares the culling buffers and the async task for a width x height screen. the caller declares
+        // the shading task after it, reading lights(), clusters() and indices() at bindings 0, 2 and 7 of its light set
+        void declare(Render::Builder& builder, uint32_t width, uint32_t height, Camera camera);
+
+        uint32_t lights() const;
+        uint32_t clusters() const;
+        uint32_t indices() const;
+
+    private:
+        void record(const Render::Task::Context& context) const;
+
+        FrustumGrid& grid;
+        Pipelines& pipelines;
+        uint32_t slices, capacity;
+
+        std::vector<Light> data;
+        float projection[16];
+
+        uint32_t width, height;
+        uint32_t lightBuffer, binBuffer, clusterBuffer, indexBuffer; // graph resources
+        const Program* frustum;
+        const Program* bin;
+        const Program* cluster;
+        Camera camera;
+    };
+}
@@ -1,7 +1,7 @@
 #pragma once
 #include <graphics/vulkan.h>
-#include <map>
 #include <vector>
+#include <memory>
 
 // device resources
 namespace Arawn {
@@ -10,7 +10,7 @@ namespace Arawn {
     // fwd declare graph for friend declaration
     namespace Render { class Graph; }
 
-    struct DescriptorLayoutInfo;
+    struct LayoutCache;
 
     class Engine {
     public:
@@ -21,7 +21,22 @@ namespace Arawn {
         Engine& operator=(Engine&&) = delete;
         Engine& operator=(const Engine&) = delete;
 
-        VK_TYPE(VkDescriptorSetLayout) setLayout(const std::vector<VK_TYPE(VkDescriptorSetLayoutBinding)>& bindings);
+        // layouts are cached by value and owned by the engine, both are safe to call from any thread
+        // flags are given per binding in the same order, eg partially bound for bindless arrays
+        VK_TYPE(VkDescriptorSetLayout) setLayout(const std::vector<VK_TYPE(VkDescriptorSetLayoutBinding)>& bindings, const std::vector<VK_ENUM(VkDescriptorBindingFlags)>& flags = {});
+        VK_TYPE(VkPipelineLayout) pipelineLayout(const std::vector<VK_TYPE(VkDescriptorSetLayout)>& setLayouts, const std::vector<VK_TYPE(VkPushConstantRange)>& ranges = {});
+
+        struct LayoutStatistics {
+            uint64_t setLayoutHits, setLayoutMisses;
+            uint64_t pipelineLayoutHits, pipelineLayoutMisses;
+        };
+
+        LayoutStatistics layoutStatistics() const;
+
+        // value of the last submit on the queue that has finished executing
+        uint64_t completed(QueueType type) const;
+        // blocks until the queue's timeline reaches value
+        void wait(QueueType type, uint64_t value) const;
 
         VK_TYPE(VkInstance) instance;   // vulkan instance
         VK_TYPE(VkPhysicalDevice) gpu;  // selected gpu
@@ -29,10 +44,18 @@ namespace Arawn {
         
         uint32_t family[5];
         VK_TYPE(VkQueue) queue[5];
+        VK_TYPE(VkSemaphore) timeline[5]; // monotonic counter per queue, every submit signals the next value
+        uint64_t value[5];                // last value handed out for the queue's timeline
+
+        bool primitiveIds; // gl_PrimitiveID in fragment shaders, the geometry shader feature. the visibility render mode needs it
 
         VK_TYPE(VmaAllocator) allocator;
+
+        // shared by every pipeline creation, persisted to disk between runs
+        VK_TYPE(VkPipelineCache) pipelineCache;
         
-        std::map<DescriptorLayoutInfo, VK_TYPE(VkDescriptorSetLayout)> setLayouts;
+    private:
+        std::unique_ptr<LayoutCache> layouts;
     };
 
 	extern Engine engine;
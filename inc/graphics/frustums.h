@@ -0,0 +1,52 @@
+#pragma once
+#include <graphics/engine.h>
+#include <graphics/renderer.h>
+#include <graphics/resources/buffer.h>
+#include <graphics/resources/program.h>
+#include <memory>
+#include <vector>
+
+namespace Arawn {
+    // std430 layout of Frustum in the light culling shaders, view space side planes of a screen tile
+    struct Frustum {
+        float planes[4][4];
+    };
+
+    // per tile frustums read by light culling. the grid only depends on the projection, the screen size and
+    // the tile size, so it is kept across frames and only rebuilt when one of them changes. rebuilds are
+    // recorded into the frame's own command buffer, no submit is waited on
+    class FrustumGrid {
+    public:
+        FrustumGrid(uint32_t frameCount);
+
+        FrustumGrid(const FrustumGrid&) = delete;
+        FrustumGrid& operator=(const FrustumGrid&) = delete;
+        FrustumGrid(FrustumGrid&&) = delete;
+        FrustumGrid& operator=(FrustumGrid&&) = delete;
+
+        // dispatches cull/frustum.comp if the frame's grid was built for another projection, screen or tile size,
+        // the caller binds the camera holding proj to set 0. call from a single compute task per frame.
+        // returns whether the grid was rebuilt, the writes are visible to later compute shaders
+        bool update(const Render::Task::Context& context, const Program& program, const float proj[16], uint32_t width, uint32_t height, uint32_t tileSize);
+
+        uint32_t tilesX() const;
+        uint32_t tilesY() const;
+
+        // grid of the frame, bound to binding 1 of the light culling set. update must have run for the frame first,
+        // earlier in the same task, the buffer is only allocated once the screen and tile size are known
+        VK_TYPE(VkBuffer) buffer(const Render::Task::Context& context) const;
+
+    private:
+        struct Grid {
+            std::unique_ptr<Buffer> frustums;
+            uint32_t capacity = 0;   // frustums the buffer holds
+            uint64_t generation = 0; // generation the grid was last built for
+        };
+
+        float projection[16];
+        uint32_t width, height, tileSize;
+        uint32_t x, y;
+        uint64_t generation;
+        std::vector<Grid> grids; // [frame]
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <graphics/engine.h>
+#include <graphics/renderer.h>
+#include <graphics/pyramid.h>
+#include <graphics/meshlet.h>
+#include <graphics/resources/buffer.h>
+#include <graphics/resources/program.h>
+#include <graphics/resources/staging.h>
+
+namespace Arawn {
+    // index and vertex range of a mesh in the shared geometry buffers
+    struct Mesh {
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t meshletOffset; // filled in when the mesh is added
+        uint32_t meshletCount;
+    };
+
+    // std430 layout of Instance in the culling and transform shaders
+    struct Instance {
+        float model[16];
+        float sphere[4]; // object space bounding sphere, centre + radius
+        uint32_t mesh;
+        uint32_t material;
+        uint32_t padding[2];
+    };
+
+    // scene instances frustum culled on the gpu into a compacted indirect draw list,
+    // a pass draws every visible instance with a single vkCmdDrawIndexedIndirectCount
+    class Instances {
+    public:
+        // meshlet draws are clamped to drawCapacity, the size of the meshlet command buffer
+        Instances(StagingRing& staging, uint32_t capacity = 131072, uint32_t meshCapacity = 4096, uint32_t meshletCapacity = 262144, uint32_t drawCapacity = 1048576);
+
+        Instances(const Instances&) = delete;
+        Instances& operator=(const Instances&) = delete;
+        Instances(Instances&&) = delete;
+        Instances& operator=(Instances&&) = delete;
+
+        // contents are streamed through the staging ring and visible to frames rendered after the next flush,
+        // updating an added instance orders that flush after the frames already submitted
+        uint32_t mesh(const Mesh& mesh);
+        // the mesh's index range must hold the indices reordered by buildMeshlets
+        uint32_t mesh(const Mesh& mesh, const std::vector<Meshlet>& meshlets);
+        uint32_t add(const Instance& instance);
+        void update(uint32_t instance, const Instance& data);
+        uint32_t count() const;
+
+        // sizes of the graph buffers written by cull and read by draw, the command buffer needs
+        // storage and indirect usage, the count buffer additionally transfer dst usage
+        uint64_t commandSize() const;
+        uint64_t meshletCommandSize() const;
+        static constexpr uint64_t countSize = sizeof(uint32_t);
+
+        // resets the count and dispatches cull/instance.comp, the caller binds the camera to set 0
+        void cull(const Render::Task::Context& context, const Program& program, VK_TYPE(VkBuffer) commands, VK_TYPE(VkBuffer) count) const;
+        // dispatches cull/occlusion.comp, additionally dropping instances behind the depth pyramid, in general layout
+        void cull(const Render::Task::Context& context, const Program& program, VK_TYPE(VkBuffer) commands, VK_TYPE(VkBuffer) count, const DepthPyramid& pyramid, VK_TYPE(VkImageView) view) const;
+        // binds the instance buffer read through gl_InstanceIndex to set 1 of the transform shaders
+        void bind(const Render::Task::Context& context, const Program& program) const;
+        // binds the instances, meshes and the shared geometry buffers to set 4 of the visibility resolve shaders,
+        // the vertex and index buffers need storage usage. the visibility pass must be drawn with draw, the resolve
+        // indexes triangles from the mesh's first index and gl_PrimitiveID restarts at every meshlet draw
+        void bindGeometry(const Render::Task::Context& context, const Program& program, VK_TYPE(VkBuffer) vertices, VK_TYPE(VkBuffer) indices) const;
+        // dispatches cull/meshlet.comp, writing a draw per meshlet inside the frustum and not facing away from the eye
+        void cullMeshlets(const Render::Task::Context& context, const Program& program, VK_TYPE(VkBuffer) commands, VK_TYPE(VkBuffer) count) const;
+
+        // the caller binds the pipeline, the geometry buffers and the remaining sets
+        void draw(VK_TYPE(VkCommandBuffer) cmd, VK_TYPE(VkBuffer) commands, VK_TYPE(VkBuffer) count) const;
+        // not for the visibility pass, its triangle ids would be relative to each meshlet
+        void drawMeshlets(VK_TYPE(VkCommandBuffer) cmd, VK_TYPE(VkBuffer) commands, VK_TYPE(VkBuffer) count) const;
+
+    private:
+        // resets the count and binds the culling buffers, binding 4 is the pyramid or the meshlets if either is given
+        void record(const Render::Task::Context& context, const Program& program, VK_TYPE(VkBuffer) commands, VK_TYPE(VkBuffer) count, const VK_TYPE(VkDescriptorImageInfo)* pyramid, bool perMeshlet) const;
+
+        StagingRing& staging;
+        uint32_t capacity, instanceCount;
+        uint32_t meshCapacity, meshCount;
+        uint32_t meshletCapacity, meshletCount;
+        uint32_t drawCapacity;
+
+        Buffer instances;
+        Buffer meshes;
+        Buffer meshlets;
+    };
+}
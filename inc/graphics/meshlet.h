@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace Arawn {
+    // std430 layout of Meshlet in cull/meshlet.comp, bounds are in object space
+    struct Meshlet {
+        float sphere[4];      // centre + radius
+        float cone[4];        // average triangle normal + cutoff, back facing when seen from within the cone
+        uint32_t firstIndex;  // relative to the mesh's first index
+        uint32_t indexCount;
+        uint32_t padding[2];
+    };
+
+    // clusters of a mesh, indices are reordered so every meshlet's triangles are contiguous.
+    // the reordered indices replace the mesh's indices in the shared index buffer
+    struct Meshlets {
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> indices;
+    };
+
+    // greedily splits the index buffer into clusters of at most maxVertices unique vertices and maxTriangles triangles,
+    // positions are 3 floats read every stride bytes
+    Meshlets buildMeshlets(const uint32_t* indices, uint32_t indexCount, const void* positions, uint32_t vertexCount, uint32_t stride, uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <graphics/engine.h>
+#include <graphics/resources/program.h>
+#include <util/threadpool.h>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <deque>
+
+namespace Arawn {
+    // compiles every program reachable from the render settings on worker threads at startup,
+    // filling the engine's pipeline cache so that settings switches become a lookup
+    class Pipelines {
+    public:
+        struct Permutation {
+            std::string compute;            // empty for graphics programs
+            std::string vertex, fragment;
+            Program::Target target;
+
+            friend bool operator==(const Permutation&, const Permutation&) = default;
+        };
+
+        // colour is the swapchain format presented to
+        Pipelines(VK_ENUM(VkFormat) colour);
+        ~Pipelines();
+
+        Pipelines(const Pipelines&) = delete;
+        Pipelines& operator=(const Pipelines&) = delete;
+        Pipelines(Pipelines&&) = delete;
+        Pipelines& operator=(Pipelines&&) = delete;
+
+        // true once every enumerated permutation has compiled
+        bool ready() const;
+        uint32_t compiled() const;
+        uint32_t count() const;
+
+        // blocks until the permutation has compiled, permutations not enumerated are compiled on the calling thread
+        const Program& get(const Permutation& permutation);
+
+        // programs used by the passes for every render, culling, depth and anti alias mode
+        static std::vector<Permutation> enumerate(VK_ENUM(VkFormat) colour);
+
+    private:
+        static Program* compile(const Permutation& permutation);
+
+        std::vector<Permutation> permutations;
+        std::vector<std::unique_ptr<Program>> programs;          // [permutation]
+        std::unique_ptr<std::atomic<bool>[]> done;               // [permutation]
+        std::atomic<uint32_t> finished;
+
+        std::mutex mutex;
+        std::deque<std::pair<Permutation, std::unique_ptr<Program>>> extra; // compiled on demand
+
+        ThreadPool workers;
+        std::thread thread; // drives the worker dispatch without blocking startup
+    };
+}
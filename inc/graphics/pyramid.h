@@ -0,0 +1,35 @@
+#pragma once
+#include <graphics/engine.h>
+#include <graphics/renderer.h>
+#include <graphics/resources/program.h>
+
+namespace Arawn {
+    // hierarchical max depth built from the depth prepass, read by occlusion culling.
+    // level 0 is half the depth resolution rounded up, every texel holds the farthest depth of its 2x2 footprint.
+    // later levels round down, the last texel of an odd sized level folds in the dropped row or column
+    class DepthPyramid {
+    public:
+        DepthPyramid(uint32_t width, uint32_t height);
+        ~DepthPyramid();
+
+        DepthPyramid(const DepthPyramid&) = delete;
+        DepthPyramid& operator=(const DepthPyramid&) = delete;
+        DepthPyramid(DepthPyramid&&) = delete;
+        DepthPyramid& operator=(DepthPyramid&&) = delete;
+
+        // extent of the graph image holding the pyramid, r32 float with storage and sampled usage
+        uint32_t width() const;
+        uint32_t height() const;
+        uint32_t levels() const;
+
+        // reduces depth, in shader read only layout, into every level of the pyramid graph image, in general layout.
+        // first reduces the depth with cull/hiz.comp, its MULTISAMPLED permutation for a multisampled prepass, the rest of the levels with cull/hiz.comp
+        void build(const Render::Task::Context& context, const Program& first, const Program& rest, VK_TYPE(VkImageView) depth, uint32_t pyramid) const;
+
+        // nearest sampler used to fetch the depth and pyramid texels
+        VK_TYPE(VkSampler) sampler;
+
+    private:
+        uint32_t x, y, levelCount;
+    };
+}
@@ -1,121 +1,204 @@
 #pragma once
 #include <graphics/engine.h>
 #include <graphics/swapchain.h>
+#include <graphics/resources/image.h>
+#include <graphics/resources/buffer.h>
+#include <graphics/resources/staging.h>
+#include <graphics/resources/descriptor.h>
+#include <util/threadpool.h>
 #include <memory_resource>
+#include <functional>
 
 namespace Arawn::Render {
-    
+    class Graph;
+
     struct Resource {
-        enum Type { IMAGE, BUFFER, ATTACHMENT } type : 8;
-        uint32_t levels : 8, x : 16, y : 16, z : 16;
+        enum Type { IMAGE, BUFFER, ATTACHMENT, SWAPCHAIN } type : 8;
+        uint32_t levels : 8, samples : 8, x : 16, y : 16, z : 16;
         VK_ENUM(VkFormat) format;
-        union {
-            VK_TYPE(VkImage) image;
-            VK_TYPE(VkBuffer) buffer;
-        };
-        VK_TYPE(VkDeviceMemory) memory;
+        VK_ENUM(VkImageUsageFlags) usage; // buffer usage flags when type == BUFFER
+        uint64_t size;                    // buffer size in bytes
     };
     
     class Task {
-        /*
-        VkSubmitInfo info {
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .pNext = nullptr, 
-            .waitSemaphoreCount = 0, .pWaitSemaphores = nullptr, .pWaitDstStageMask = nullptr, 
-            .commandBufferCount = 0, .pCommandBuffers = nullptr, 
-            .signalSemaphoreCount = 0, .pSignalSemaphores = nullptr
+        friend class Graph;
+    public:
+        // render pass state inherited by secondary command buffers, a null render pass records outside of one
+        struct Inheritance {
+            VK_TYPE(VkRenderPass) renderPass;
+            uint32_t subpass;
+            VK_TYPE(VkFramebuffer) framebuffer;
         };
 
-        vkQueueSubmit(engine.graphics.queue, 1, &info, renderer.in_flight[frame_index]);
-        */
+        struct Context;
+        using Callback = std::function<void(const Context&)>;
+        using Record = std::function<void(const Context&, uint32_t begin, uint32_t end)>; // records items [begin, end)
+
+        struct Context {
+            VK_TYPE(VkCommandBuffer) cmd;
+            QueueType queue;
+            uint32_t frameIndex;
+            uint32_t imageIndex;
+            uint32_t thread;     // recording thread, 0 outside of parallel records
+            Graph& graph;
+
+            // splits count items in chunks recorded on worker threads into secondary command buffers,
+            // executed into cmd in chunk order. the render pass must have been begun with secondary contents
+            void parallel(uint32_t count, uint32_t chunk, const Inheritance& inheritance, const Record& record) const;
+
+            // set valid until the frame is rendered again, safe to call from parallel records
+            VK_TYPE(VkDescriptorSet) descriptor(const Program& program, uint32_t set) const;
+        };
+
+        Task(QueueType queue, Callback callback, std::pmr::memory_resource* cache);
+
+        // declares how the task accesses a resource, read/write is derived from the access flags
+        Task& use(uint32_t resource, Image::Usage usage);
+        Task& use(uint32_t resource, Buffer::Usage usage);
+
+    private:
+        QueueType queue;
+        Callback callback;
+        std::pmr::vector<std::pair<uint32_t, Image::Usage>> images;
+        std::pmr::vector<std::pair<uint32_t, Buffer::Usage>> buffers;
     };
 
     struct Builder {
     private:
         std::pmr::monotonic_buffer_resource cache;
     public:
+        uint32_t image(VK_ENUM(VkFormat) format, uint32_t x, uint32_t y, VK_ENUM(VkImageUsageFlags) usage, uint32_t samples = 1, uint32_t levels = 1);
+        uint32_t buffer(uint64_t size, VK_ENUM(VkBufferUsageFlags) usage);
+        uint32_t swapchain();
+
+        // tasks are executed in the order they are declared
+        Task& task(QueueType queue, Task::Callback callback);
+
         std::pmr::vector<Resource> resources{ &cache };
         std::pmr::vector<Task>     tasks{ &cache };
     };
 
-    class Graph {    
-        struct Task {
-            enum { PRESENT, GRAPHICS, COMPUTE, ASYNC, TRANSFER } queueType : 3;
+    class Graph {
+        friend struct Task::Context;
+    public:
+        Graph(Builder& builder, Swapchain& swapchain, uint32_t frameCount);
+        ~Graph();
+
+        Graph(Graph&&) = delete;
+        Graph& operator=(Graph&&) = delete;
+        Graph(const Graph&) = delete;
+        Graph& operator=(const Graph&) = delete;
+
+        // returns false if the swapchain is out of date and the graph must be rebuilt
+        bool render();
+
+        // uploads batched in the ring are flushed each frame, the frame waits on them and acquires their ownership
+        void stream(StagingRing& ring);
 
+        // device memory of the graph's resources across all frames in flight
+        struct Statistics {
+            uint64_t naive;   // bytes if every resource had its own allocation
+            uint64_t aliased; // bytes committed after aliasing non-overlapping resources
+            uint64_t lazy;    // bytes requested from lazily allocated memory, not committed on tile based hardware
         };
-        
+
+        const Statistics& statistics() const;
+
+        VK_TYPE(VkImage) image(uint32_t resource, uint32_t frameIndex) const;
+        VK_TYPE(VkImageView) view(uint32_t resource, uint32_t frameIndex) const;
+        // single level view of a mip mapped image, destroyed with the image
+        VK_TYPE(VkImageView) view(uint32_t resource, uint32_t frameIndex, uint32_t level) const;
+        VK_TYPE(VkBuffer) buffer(uint32_t resource, uint32_t frameIndex) const;
+
+    private:
+        void compile(Builder& builder);
+        void allocate();
+        // blocks until the frame's previous submits have completed
+        void wait(uint32_t frame, uint64_t timeout) const;
+        void parallel(const Task::Context& context, uint32_t count, uint32_t chunk, const Task::Inheritance& inheritance, const Task::Record& record);
+
+        // memory dependency recorded before a task, or after the last task of a batch.
+        // graph resources are exclusive to one queue family, a barrier pair releases and acquires them when another family needs their contents
+        struct Barrier {
+            uint32_t resource;
+            VK_ENUM(VkPipelineStageFlags) srcStages, dstStages;
+            VK_ENUM(VkAccessFlags) srcAccess, dstAccess;
+            VK_ENUM(VkImageLayout) oldLayout, newLayout;
+            uint32_t srcFamily, dstFamily; // queue family ownership transfer, ignored if equal
+        };
+
+        // compiled task
         struct Node {
-            uint32_t waitCount, emitCount;
-            VK_TYPE(VkSemaphore)* wait;
-            VK_TYPE(VkSemaphore)* emit;
+            Task::Callback callback;
+            uint32_t barrierIndex, barrierCount;
+            VK_ENUM(VkPipelineStageFlags) aliasSrcStages, aliasDstStages; // memory reused from a resource whose lifetime ended
         };
 
-        uint32_t frameCount, frameIndex, imageCount, imageIndex;
-        VK_TYPE(VkSemaphore)* frameReady;
-        VK_TYPE(VkFence)*     imageReady;
+        // first and last node to access a resource, used to alias memory between resources
+        struct Lifetime {
+            uint32_t first, last;
+            VK_ENUM(VkPipelineStageFlags) firstStages, lastStages;
+            uint32_t queues; // mask of queue types accessing the resource
+        };
 
-        std::pmr::monotonic_buffer_resource cache;
-        std::pmr::vector<VK_TYPE(VkFence)> fences{ &cache };
-        std::pmr::vector<VK_TYPE(VkSemaphore)> semaphores{ &cache };
-        std::pmr::vector<VK_TYPE(VkPipeline)> pipelines{ &cache };
-        std::pmr::vector<VK_TYPE(VkPipelineLayout)> layouts{ &cache };
-        std::pmr::vector<VK_TYPE(VkImageView)> imageViews{ &cache };
-        std::pmr::vector<VK_TYPE(VkRenderPass)> renderpasses{ &cache };
-        std::pmr::vector<VK_TYPE(VkFramebuffer)> framebuffers{ &cache };
-        std::pmr::vector<VK_TYPE(VkCommandBuffer)> commands{ &cache };
-        std::pmr::vector<VK_TYPE(VkDescriptorSet)> descriptorSets{ &cache };
-
-        Graph(Builder& builder, uint32_t frameCount, uint32_t imageCount)
-         : frameCount(frameCount), frameIndex(0), imageCount(imageCount), imageIndex(0)
-        {
-            
-        }
+        // consecutive nodes on the same queue, recorded into a single command buffer and submit
+        struct Batch {
+            QueueType queue;
+            uint32_t nodeIndex, nodeCount;
+            uint32_t barrierIndex, barrierCount; // trailing barriers, eg ownership release, present transition
+            VK_ENUM(VkPipelineStageFlags) acquireStages; // non zero if the batch waits on the swapchain image
+            bool present;                                // true if the batch signals the frame ready
+        };
 
-        void render() {
-            
-            { // acquire image 
-                // const uint64_t timeout = 1000000000;
-                // VK_ASSERT(vkWaitForFences(engine.device, 1, &frameReady[frame.index], true, timeout));
-                
-                // acquire next swapchain image
-                // VkResult res = vkAcquireNextImageKHR(engine.device, swapchain.swapchain, timeout, imageReady[frame.index], nullptr, &image.index);
-            
-                // { // recreate if out of date
-                //     if (res == VK_ERROR_OUT_OF_DATE_KHR)
-                //     {
-                //         recreate();
-                //         return;
-                //     }
-                //     else if (res != VK_SUBOPTIMAL_KHR)
-                //     {
-                //         VK_ASSERT(res);
-                //     }
-                // }
-            }
+        // cross queue dependency, dst waits on the queue timeline value signalled by src
+        struct Edge {
+            uint32_t src, dst;
+            VK_ENUM(VkPipelineStageFlags) stages;
+        };
 
-            { // record command buffers
-                // multithread here, each component can record to a seperate worker
-            }
+        // per thread secondary command buffers, reset once per frame
+        struct Recorder {
+            VK_TYPE(VkCommandPool) pools[5];
+            std::vector<VK_TYPE(VkCommandBuffer)> buffers[5];
+            uint32_t used[5];
+        };
 
-            { // submit command buffers
-                // ...
-            }
+        struct Handle {
+            VK_TYPE(VkImage) image;
+            VK_TYPE(VkImageView) view;
+            VK_TYPE(VkBuffer) buffer;
+            VK_TYPE(VmaAllocation) allocation; // dedicated allocation, null if bound to a shared heap
+            uint32_t levelViews;               // first of the image's per level views, UINT32_MAX if it has a single level
+        };
 
-            { // present to screen
-                // VkPresentInfoKHR info{ 
-                //     VK_STRUCTURE_TYPE_PRESENT_INFO_KHR, nullptr, 
-                //     1, &frame.ready[frame.index], // wait on frame ready
-                //     1, &swapchain.swapchain, &image.index, 
-                //     nullptr
-                // };
-                // VkResult res = vkQueuePresentKHR(engine.present.queue, &info);
-        
-                // if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) {
-                //     return;
-                // } else {
-                //     VK_ASSERT(res);
-                // }
-            }
-        }
+        Swapchain& swapchain;
+        uint32_t frameCount, frameIndex, imageCount, imageIndex;
+
+        std::pmr::monotonic_buffer_resource cache;
+        std::pmr::vector<Resource> resources{ &cache };
+        std::pmr::vector<Lifetime> lifetimes{ &cache };
+        std::pmr::vector<Node> nodes{ &cache };
+        std::pmr::vector<Batch> batches{ &cache };
+        std::pmr::vector<Edge> edges{ &cache };
+        std::pmr::vector<Barrier> barriers{ &cache };
+
+        std::pmr::vector<Handle> handles{ &cache };                          // [frame * resources + resource]
+        std::pmr::vector<VK_TYPE(VkImageView)> levelViews{ &cache };         // [handle.levelViews + level]
+        std::pmr::vector<VK_TYPE(VmaAllocation)> heaps{ &cache };           // [frame * heaps + heap]
+        Statistics stats;
+        std::pmr::vector<VK_TYPE(VkImage)> images{ &cache };                 // [image]
+        std::pmr::vector<VK_TYPE(VkImageView)> imageViews{ &cache };         // [image]
+        std::pmr::vector<uint8_t> presented{ &cache };                       // [image] false until the image is first presented, its layout is undefined
+        bool presents;                                                       // false if no task uses the swapchain, the frame is neither acquired nor presented
+        VK_TYPE(VkCommandPool) pools[5];
+        std::pmr::vector<VK_TYPE(VkCommandBuffer)> commands{ &cache };       // [frame * batches + batch]
+        std::pmr::vector<Recorder> recorders{ &cache };                      // [frame * threads + thread]
+        std::pmr::vector<uint64_t> values{ &cache };                         // [frame * batches + batch] timeline value signalled on the batch's queue
+        std::pmr::vector<VK_TYPE(VkSemaphore)> imageReady{ &cache };         // [frame]
+        std::pmr::vector<VK_TYPE(VkSemaphore)> frameReady{ &cache };         // [frame]
+        ThreadPool workers;
+        StagingRing* staging = nullptr;
+        DescriptorAllocator descriptors; // [frame * threads + thread] pools reset when the frame is reused
     };
 
     class Forward {
@@ -4,6 +4,10 @@
 namespace Arawn {
 	struct Buffer { 
 		friend struct Graph;
+		friend class StagingRing;
+		friend class MaterialTable;
+		friend class Instances;
+		friend class FrustumGrid;
 		struct Usage { 
 			VK_ENUM(VkAccessFlags) access;
 			VK_ENUM(VkPipelineStageFlags) stages;
@@ -0,0 +1,37 @@
+#pragma once
+#include <graphics/engine.h>
+#include <graphics/resources/program.h>
+
+namespace Arawn {
+	// hands out descriptor sets from per frame pools, a frame's pools are reset in bulk instead of freeing sets.
+	// every recording thread owns its pools, threads allocate without locking
+	class DescriptorAllocator {
+	public:
+		DescriptorAllocator(uint32_t frameCount, uint32_t threadCount, uint32_t setsPerPool = 64);
+		~DescriptorAllocator();
+
+		DescriptorAllocator(const DescriptorAllocator&) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+		DescriptorAllocator(DescriptorAllocator&&) = delete;
+		DescriptorAllocator& operator=(DescriptorAllocator&&) = delete;
+
+		// invalidates every set allocated for the frame, the frame's work must have completed
+		void reset(uint32_t frameIndex);
+
+		// safe to call from recording threads, each with its own thread index. bindless sets are rejected, they come from their owner
+		VK_TYPE(VkDescriptorSet) allocate(uint32_t frameIndex, uint32_t thread, const Program& program, uint32_t set);
+
+	private:
+		struct Pools {
+			std::vector<VK_TYPE(VkDescriptorPool)> pools; // pools[active] is allocated from, earlier pools are full
+			uint32_t active;
+			uint32_t setsPerPool;
+			std::vector<std::pair<VK_ENUM(VkDescriptorType), uint32_t>> sizes; // per set, scaled by setsPerPool
+		};
+
+		VK_TYPE(VkDescriptorPool) create(Pools& pools);
+
+		uint32_t threadCount;
+		std::vector<Pools> frames; // [frame * threads + thread]
+	};
+}
@@ -4,6 +4,8 @@
 namespace Arawn {
 	struct Image { 
 		friend struct Graph;
+		friend class StagingRing;
+		friend class MaterialTable;
 		struct Usage { 
 			VK_ENUM(VkImageLayout) layout;
 			VK_ENUM(VkAccessFlags) access;
@@ -0,0 +1,52 @@
+#pragma once
+#include <graphics/engine.h>
+#include <graphics/resources/image.h>
+#include <graphics/resources/buffer.h>
+#include <graphics/resources/program.h>
+#include <graphics/resources/staging.h>
+
+namespace Arawn {
+	// std430 layout of Material in the fragment shaders
+	struct Material {
+		static constexpr uint32_t none = 0xffffffff; // texture index of an attribute read from the constant
+
+		float albedo[3];
+		float metallic;
+		float roughness;
+		uint32_t flags; // derived from the texture indices when added to the table
+		uint32_t albedoMap = none, metallicMap = none, roughnessMap = none, normalMap = none;
+		uint32_t padding[2];
+	};
+
+	// scene wide material buffer and bindless texture array, bound once per frame and indexed by each instance's material id
+	class MaterialTable {
+	public:
+		// program reflects the table's set, the size of its texture array bounds the texture count
+		MaterialTable(const Program& program, uint32_t set, StagingRing& staging, uint32_t capacity = 4096);
+		~MaterialTable();
+
+		MaterialTable(const MaterialTable&) = delete;
+		MaterialTable& operator=(const MaterialTable&) = delete;
+		MaterialTable(MaterialTable&&) = delete;
+		MaterialTable& operator=(MaterialTable&&) = delete;
+
+		// descriptors are written immediately, the array is updated after bind so textures stream in while frames using the table are in flight.
+		// the image must be in shader read only layout, returns its index in the texture array
+		uint32_t texture(const Image& image);
+		// material contents are streamed through the staging ring, returns the material id
+		uint32_t material(const Material& material);
+
+		void bind(VK_TYPE(VkCommandBuffer) cmd, const Program& program) const;
+
+	private:
+		StagingRing& staging;
+		uint32_t set;
+		uint32_t textureCapacity, textureCount;
+		uint32_t materialCapacity, materialCount;
+
+		Buffer materials;
+		VK_TYPE(VkSampler) sampler;
+		VK_TYPE(VkDescriptorPool) pool;
+		VK_TYPE(VkDescriptorSet) descriptorSet;
+	};
+}
@@ -1,13 +1,51 @@
 #pragma once
 #include <graphics/vulkan.h>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <utility>
 
 namespace Arawn {
+	// layout of the shared vertex buffer, shader input locations 0-4 in member order. the visibility shaders read it as 14 floats
+	struct Vertex {
+		float position[3];
+		float texcoord[2];
+		float normal[3];
+		float tangent[3];
+		float bi_tangent[3];
+	};
+
 	class Program {
 	public:
+		// attachments of the subpass a graphics pipeline is compatible with
+		struct Target {
+			std::vector<VK_ENUM(VkFormat)> colour;
+			VK_ENUM(VkFormat) depth; // undefined if the subpass has no depth attachment
+			uint32_t samples;
+			bool resolve;            // multisampled colour is resolved in the subpass
+			bool depthWrite;         // false when depth is laid down by a prepass
+			// merged deferred pass: the g-buffer in colour and depth are read as input attachments by a second,
+			// lighting subpass that writes this format single sampled. undefined for single subpass targets
+			VK_ENUM(VkFormat) merged;
+			uint32_t subpass;        // subpass of a merged pass the pipeline runs in, 0 g-buffer, 1 lighting
+
+			friend bool operator==(const Target&, const Target&) = default;
+		};
+
 		Program(const char* compute);
 		Program(const char* vertex, const char* fragment);
+		Program(const char* vertex, const char* fragment, const Target& target);
 		Program(const char* vertex, const char* geometry, const char* fragment);
 
+		// render pass the target's pipelines are compatible with, destroyed by the caller.
+		// merged passes are created ready to record, their g-buffer is cleared and never stored. created with
+		// transient and input attachment usage, the graph backs the g-buffer with lazily allocated memory
+		static VK_TYPE(VkRenderPass) renderPass(const Target& target);
+
+		// path of the spir-v compiled from source, relative to res/shader, with exactly the given permutation defines.
+		// looked up in the manifest written by the build, tunables shared with the engine apply to every permutation
+		static std::string permutation(std::string_view source, const std::vector<std::string_view>& defines = {});
+
 		~Program() noexcept;
 
 		Program(const Program&) = delete;
@@ -16,8 +54,16 @@ namespace Arawn {
 		Program(Program&&) noexcept;
 		Program& operator=(Program&&) noexcept;
 	// private:
+		// reflected descriptor set, counts size the pools sets are allocated from
+		struct Set {
+			VK_TYPE(VkDescriptorSetLayout) layout;
+			std::vector<std::pair<VK_ENUM(VkDescriptorType), uint32_t>> counts;
+			bool bindless; // holds a runtime sized array, allocated once by its owner rather than per frame
+		};
+
 		VK_TYPE(VkPipeline) pipeline;
 		VK_TYPE(VkPipelineLayout) layout;
+		std::vector<Set> sets; // [set index]
 	};
 }
 
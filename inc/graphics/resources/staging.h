@@ -0,0 +1,66 @@
+#pragma once
+#include <graphics/engine.h>
+#include <graphics/resources/buffer.h>
+#include <graphics/resources/image.h>
+#include <deque>
+
+namespace Arawn {
+	// streams data into device local resources through a persistently mapped ring, copies are batched and submitted on the transfer queue
+	class StagingRing {
+	public:
+		StagingRing(uint64_t capacity);
+		~StagingRing();
+
+		StagingRing(const StagingRing&) = delete;
+		StagingRing& operator=(const StagingRing&) = delete;
+		StagingRing(StagingRing&&) = delete;
+		StagingRing& operator=(StagingRing&&) = delete;
+
+		// copies data into the ring, the copy to dst is recorded on the next flush. inFlight marks a range frames already
+		// submitted may still read, the flush then waits for every queue's last submit before overwriting it
+		void upload(Buffer& dst, const void* data, uint64_t size, uint64_t offset = 0, QueueType consumer = GRAPHICS, bool inFlight = false);
+		// image is left in shader read only layout
+		void upload(Image& dst, const void* data, uint64_t size, uint32_t width, uint32_t height, QueueType consumer = GRAPHICS);
+
+		// submits the batched copies, returns the transfer timeline value consumers must wait on, 0 if none since the last call
+		// queues is a mask of (1 << QueueType) recording this frame, every released upload must have a queue of its family to acquire it
+		uint64_t flush(uint32_t queues);
+
+		// records the ownership acquire of flushed uploads consumed by the queue, when its family differs from the transfer family
+		void acquire(VK_TYPE(VkCommandBuffer) cmd, QueueType queue);
+
+	private:
+		struct Copy {
+			VK_TYPE(VkBuffer) buffer;
+			VK_TYPE(VkImage) image;
+			uint64_t src, dst, size;
+			uint32_t width, height;
+			QueueType consumer;
+			bool inFlight;
+		};
+
+		// ring range and command buffer in use until the transfer timeline reaches value
+		struct Submit {
+			VK_TYPE(VkCommandBuffer) cmd;
+			uint64_t end;
+			uint64_t value;
+		};
+
+		uint64_t allocate(uint64_t size, uint64_t alignment);
+		void reclaim();
+		void submit();
+
+		uint64_t capacity, head, tail;
+		uint64_t pendingValue; // last flush not yet returned to a consumer
+		uint8_t* mapped;
+
+		VK_TYPE(VkBuffer) buffer;
+		VK_TYPE(VmaAllocation) memory;
+		VK_TYPE(VkCommandPool) pool;
+
+		std::vector<Copy> copies;   // recorded on the next flush
+		std::vector<Copy> released; // flushed, awaiting acquire on the consumer queue
+		std::deque<Submit> submits;
+		std::vector<VK_TYPE(VkCommandBuffer)> free;
+	};
+}
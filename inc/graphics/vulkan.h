@@ -67,18 +67,51 @@
 #define MAX_FRAMES_IN_FLIGHT 3
 #endif
 
-#ifndef MAX_LIGHTS
+// light culling tunables shared with the shaders, the build defines them prefixed as ARAWN_<name>
+#ifdef ARAWN_MAX_LIGHTS
+#define MAX_LIGHTS ARAWN_MAX_LIGHTS
+#else
 #define MAX_LIGHTS 4096
 #endif
 
-#ifndef MAX_LIGHTS_PER_CLUSTER
-#define MAX_LIGHTS_PER_CLUSTER 63
+#ifdef ARAWN_TILE_SIZE
+#define TILE_SIZE ARAWN_TILE_SIZE
+#else
+#define TILE_SIZE 16
+#endif
+
+#ifdef ARAWN_BIN_SIZE
+#define BIN_SIZE ARAWN_BIN_SIZE
+#else
+#define BIN_SIZE 8
+#endif
+
+#ifdef ARAWN_MAX_LIGHTS_PER_BIN
+#define MAX_LIGHTS_PER_BIN ARAWN_MAX_LIGHTS_PER_BIN
+#else
+#define MAX_LIGHTS_PER_BIN 1023
+#endif
+
+#ifdef ARAWN_MAX_DEPTH_SLICES
+#define MAX_DEPTH_SLICES ARAWN_MAX_DEPTH_SLICES
+#else
+#define MAX_DEPTH_SLICES 256
+#endif
+
+#ifdef ARAWN_DEPTH_SLICES
+#define DEPTH_SLICES ARAWN_DEPTH_SLICES
+#else
+#define DEPTH_SLICES 32
 #endif
 
-#ifndef MAX_LIGHTS_PER_TILE
-#define MAX_LIGHTS_PER_TILE 127
+#ifdef ARAWN_ZBIN_COUNT
+#define ZBIN_COUNT ARAWN_ZBIN_COUNT
+#else
+#define ZBIN_COUNT 1024
 #endif
 
+static_assert(MAX_LIGHTS <= 65535, "light indices are packed in 16 bits");
+
 #ifndef MAX_MIPMAP_LEVEL 
 #define MAX_MIPMAP_LEVEL 8
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+// fixed set of worker threads running indexed jobs, the dispatching thread participates as thread 0
+class ThreadPool {
+public:
+    using Job = std::function<void(uint32_t thread, uint32_t index)>;
+
+    ThreadPool(uint32_t count = std::max(std::thread::hardware_concurrency(), 1u)) {
+        for (uint32_t thread = 1; thread < count; ++thread) {
+            threads.emplace_back([this, thread]() { work(thread); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t size() const { return static_cast<uint32_t>(threads.size()) + 1; }
+
+    // runs job for every index in [0, count) and blocks until all of them are done, must not be nested
+    void dispatch(uint32_t count, const Job& job) {
+        if (count == 0) return;
+
+        {
+            std::unique_lock lock(mutex);
+            finished.wait(lock, [&]() { return active == 0; }); // late workers of the previous dispatch
+            current = &job;
+            total = count;
+            next = 0;
+            done = 0;
+            ++generation;
+        }
+        wake.notify_all();
+
+        run(0);
+
+        std::unique_lock lock(mutex);
+        finished.wait(lock, [&]() { return done == total && active == 0; });
+        current = nullptr;
+    }
+
+private:
+    void run(uint32_t thread) {
+        for (uint32_t index = next++; index < total; index = next++) {
+            (*current)(thread, index);
+            if (++done == total) {
+                std::lock_guard lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+
+    void work(uint32_t thread) {
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                ++active;
+            }
+
+            run(thread);
+
+            {
+                std::lock_guard lock(mutex);
+                --active;
+            }
+            finished.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    bool stopping = false;
+    uint64_t generation = 0;
+    uint32_t active = 0, total = 0;
+    std::atomic<uint32_t> next = 0, done = 0;
+    const Job* current = nullptr;
+    std::vector<std::thread> threads;
+};
@@ -1,41 +1,48 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout (std140, set = 2, binding = 0) uniform Material {
+struct Material {
     vec3 albedo;
     float metallic;
     float roughness;
     uint flags;
-} material;
+    uint albedo_map;
+    uint metallic_map;
+    uint roughness_map;
+    uint normal_map;
+};
 
-layout(set = 2, binding = 1) uniform sampler2D albedo_map;
-layout(set = 2, binding = 2) uniform sampler2D metallic_map;
-layout(set = 2, binding = 3) uniform sampler2D roughness_map;
-layout(set = 2, binding = 4) uniform sampler2D normal_map;
+layout(std430, set = 2, binding = 0) readonly buffer MaterialArray { Material materials[]; };
+layout(set = 2, binding = 1) uniform sampler2D textures[]; // bindless, indexed by the material's maps
 
-layout(location = 0) in vec3 frag_position; // world position
 layout(location = 1) in vec2 frag_texcoord;
 layout(location = 2) in mat3 TBN;
+layout(location = 5) flat in uint frag_material;
 
 layout(location = 0) out vec4 out_albedo; // albedo + alpha
-layout(location = 1) out vec4 out_normal; // normal + metallic
-layout(location = 2) out vec4 out_position; // position + roughness
+layout(location = 1) out vec2 out_normal; // octahedral normal
+layout(location = 2) out vec2 out_material; // metallic + roughness, position is reconstructed from depth
 
 const uint albedo_texture_flag = 0x00000001;
 const uint metallic_texture_flag = 0x00000002;
 const uint roughness_texture_flag = 0x00000004;
 const uint normal_texture_flag = 0x00000008;
 
+vec2 oct_encode(vec3 n);
+
 void main() {
+    Material material = materials[frag_material];
+
     vec3 albedo; // read albedo material attribute
     if ((material.flags & albedo_texture_flag) == albedo_texture_flag) {
-        albedo = texture(albedo_map, frag_texcoord).rgb;
+        albedo = texture(textures[material.albedo_map], frag_texcoord).rgb;
     } else {
         albedo = material.albedo;
     }
 
     vec3 normal; // read normal material attribute
     if ((material.flags & normal_texture_flag) == normal_texture_flag) {
-        vec3 normal = texture(normal_map, frag_texcoord).rgb * 2.0 - 1.0;
+        normal = texture(textures[material.normal_map], frag_texcoord).rgb * 2.0 - 1.0;
         normal = normalize(TBN * normal);
     } else {
         normal = TBN[2];
@@ -43,21 +50,29 @@ void main() {
 
     float metallic; // read metallic material attribute
     if ((material.flags & metallic_texture_flag) == metallic_texture_flag) {
-        metallic = texture(metallic_map, frag_texcoord).r;
+        metallic = texture(textures[material.metallic_map], frag_texcoord).r;
     } else {
         metallic = material.metallic;
     }
 
     float roughness; // read roughness material attribute
     if ((material.flags & roughness_texture_flag) == roughness_texture_flag) {
-        roughness = texture(roughness_map, frag_texcoord).r;
+        roughness = texture(textures[material.roughness_map], frag_texcoord).r;
     } else {
         roughness = material.roughness;
     }
 
     out_albedo.rgb = albedo.rgb;
-    out_normal.rgb = normal.rgb;
-    out_normal.a   = metallic;
-    out_position.rgb = frag_position.rgb;
-    out_position.a   = roughness;
+    out_normal     = oct_encode(normal);
+    out_material.r = metallic;
+    out_material.g = roughness;
+}
+
+vec2 sign_not_zero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 oct_encode(vec3 n) { // octahedron folded onto the unit square
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * sign_not_zero(n.xy);
 }
\ No newline at end of file
@@ -1,8 +1,19 @@
 #version 450
-#define MAX_LIGHTS_PER_TILE 127
+// MULTISAMPLED is defined by the build for the multisampled g-buffer permutation
+#ifdef MULTISAMPLED
+#define SUBPASS_INPUT subpassInputMS
+#define LOAD(attachment, sample_index) subpassLoad(attachment, sample_index)
+#else
+#define SUBPASS_INPUT subpassInput
+#define LOAD(attachment, sample_index) subpassLoad(attachment)
+#endif
 
 const float PI      = 3.14;
 const float EPSILON = 0.01;
+#ifdef MULTISAMPLED
+const float EDGE_NORMAL = 0.95; // min cosine between the normals of samples on one surface
+const float EDGE_DEPTH  = 0.01; // max view depth difference relative to the first sample
+#endif
 
 struct Light {
     vec3 position;
@@ -11,15 +22,6 @@ struct Light {
     float curve;
 };
 
-struct Frustum {
-    vec4 planes[4];
-};
-
-struct Cluster {
-    uint light_count;
-    uint indices[MAX_LIGHTS_PER_TILE];
-};
-
 layout(std140, set = 0, binding = 0) uniform Camera {
     mat4 proj;
     mat4 view;
@@ -30,34 +32,59 @@ layout(std140, set = 0, binding = 0) uniform Camera {
     vec3 eye;
 };
 
-layout(set = 1, input_attachment_index = 0, binding = 0) uniform subpassInput albedo_attachment;
-layout(set = 1, input_attachment_index = 0, binding = 1) uniform subpassInput normal_attachment;
-layout(set = 1, input_attachment_index = 0, binding = 2) uniform subpassInput position_attachment;
+layout(set = 1, input_attachment_index = 0, binding = 0) uniform SUBPASS_INPUT albedo_attachment;
+layout(set = 1, input_attachment_index = 1, binding = 1) uniform SUBPASS_INPUT normal_attachment;   // octahedral normal
+layout(set = 1, input_attachment_index = 2, binding = 2) uniform SUBPASS_INPUT material_attachment; // metallic + roughness
+layout(set = 1, input_attachment_index = 3, binding = 3) uniform SUBPASS_INPUT depth_attachment;    // position is reconstructed from depth
 
 layout(std430, set=2, binding=0) readonly buffer LightArray { uvec3 cluster_count; uint light_count; Light lights[]; };
-layout(std430, set=2, binding=1) readonly buffer FrustumArray { Frustum frustums[]; };
-layout(std430, set=2, binding=2) readonly buffer ClusterArray { Cluster clusters[]; };
-
+layout(std430, set=2, binding=2) readonly buffer TileMaskArray { uint masks[]; }; // 1 bit per light
 
 layout(location = 0) out vec4 out_colour;
 
+#ifdef MULTISAMPLED
+layout(push_constant) uniform Samples { uint sample_count; }; // of the g-buffer
+#endif
+
 vec3 F_Schlick(float HdotV, vec3 F0);
 float D_GGX(float NdotH, float r);
 float G_SchlickGGX(float NdotV, float roughness);
 float G_Smith(float NdotV, float NdotL, float roughness);
 float attenuate(vec3 light_position, vec3 frag_position, float radius, float curve);
+vec3 oct_decode(vec2 e);
+vec4 shade(int sample_index);
+#ifdef MULTISAMPLED
+bool is_edge();
+float view_depth(float depth);
+#endif
+vec3 reconstruct_position(float depth);
 
 void main() {
-    vec4 in_albedo = subpassLoad(albedo_attachment);
+#ifdef MULTISAMPLED
+    // pixels whose samples all see the same surface are shaded once, only edge pixels are shaded per sample
+    int count = is_edge() ? int(sample_count) : 1;
+
+    out_colour = vec4(0.0);
+    for (int i = 0; i < count; ++i) {
+        out_colour += shade(i);
+    }
+    out_colour /= float(count);
+#else
+    out_colour = shade(0);
+#endif
+}
+
+vec4 shade(int sample_index) {
+    vec4 in_albedo = LOAD(albedo_attachment, sample_index);
     vec3 albedo = in_albedo.rgb;
 
-    vec4 in_normal = subpassLoad(normal_attachment);
-    vec3 normal = in_normal.rgb;
-    float metallic = in_normal.a;
+    vec3 normal = oct_decode(LOAD(normal_attachment, sample_index).rg);
 
-    vec4 in_position = subpassLoad(position_attachment);
-    vec3 frag_position = in_position.rgb;
-    float roughness = in_position.a;
+    vec2 in_material = LOAD(material_attachment, sample_index).rg;
+    float metallic = in_material.r;
+    float roughness = in_material.g;
+
+    vec3 frag_position = reconstruct_position(LOAD(depth_attachment, sample_index).r);
 
     vec3 N = normalize(normal);
     vec3 V = normalize(eye - frag_position);
@@ -66,31 +93,39 @@ void main() {
     F0 = mix(F0, albedo, metallic);
     
     // ambient component
-    out_colour = vec4(0.01 * albedo, 1.0);
+    vec4 colour = vec4(0.01 * albedo, 1.0);
 
     // for each light
     uvec2 tilecoord = uvec2(gl_FragCoord) / ((screen_size.xy - 1) / cluster_count.xy + 1);
-    uint cluster_index = tilecoord.x + tilecoord.y * cluster_count.x;
-    for (uint i = 0; i < clusters[cluster_index].light_count; ++i) {
-        
-        Light light = lights[clusters[cluster_index].indices[i]];
-        vec3 L = normalize(light.position - frag_position);
-        vec3 H = normalize(V + L);
-
-        float NdotH = max(dot(N, H), EPSILON);
-        float NdotV = max(dot(N, V), EPSILON);
-        float NdotL = max(dot(N, L), EPSILON);
-        float HdotV = max(dot(H, V), EPSILON);
+    uint tile_index = tilecoord.x + tilecoord.y * cluster_count.x;
+    uint word_count = (light_count + 31) / 32;
+    for (uint word = 0; word < word_count; ++word) {
+        uint mask = masks[tile_index * word_count + word];
+        while (mask != 0) {
+            uint bit = findLSB(mask);
+            mask &= mask - 1;
+
+            Light light = lights[word * 32 + bit];
+            vec3 L = normalize(light.position - frag_position);
+            vec3 H = normalize(V + L);
+
+            float NdotH = max(dot(N, H), EPSILON);
+            float NdotV = max(dot(N, V), EPSILON);
+            float NdotL = max(dot(N, L), EPSILON);
+            float HdotV = max(dot(H, V), EPSILON);
         
-        float A = attenuate(light.position, frag_position, light.radius, light.curve); // attenuation
-        float D = D_GGX(NdotH, roughness);
-        float G = G_Smith(NdotV, NdotL, roughness);
-        vec3  F = F_Schlick(HdotV, F0);
-
-        vec3 diffuse = albedo / max(PI * (1.0 - metallic), EPSILON);
-        vec3 specular = D * G * F / max(4.0 * NdotV * NdotL, EPSILON);
-        out_colour.rgb += (diffuse + specular) * light.colour * A * NdotL;
+            float A = attenuate(light.position, frag_position, light.radius, light.curve); // attenuation
+            float D = D_GGX(NdotH, roughness);
+            float G = G_Smith(NdotV, NdotL, roughness);
+            vec3  F = F_Schlick(HdotV, F0);
+
+            vec3 diffuse = albedo / max(PI * (1.0 - metallic), EPSILON);
+            vec3 specular = D * G * F / max(4.0 * NdotV * NdotL, EPSILON);
+            colour.rgb += (diffuse + specular) * light.colour * A * NdotL;
+        }
     }
+
+    return colour;
 }
 
 vec3 F_Schlick(float HdotV, vec3 F0) {
@@ -120,3 +155,39 @@ float attenuate(vec3 light_position, vec3 frag_position, float radius, float cur
     float r2 = radius * radius;
     return clamp(curve * max(r2 - d2, 0) / d2, 0, 1);
 }
+
+vec2 sign_not_zero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign_not_zero(n.xy);
+    return normalize(n);
+}
+
+vec3 reconstruct_position(float depth) { // world position of the fragment from its depth
+    vec2 screen = gl_FragCoord.xy / vec2(screen_size);
+    vec4 view_position = inv_proj * vec4(screen * 2.0 - 1.0, depth, 1.0);
+    view_position /= view_position.w;
+    return transpose(mat3(view)) * (view_position.xyz - view[3].xyz);
+}
+
+#ifdef MULTISAMPLED
+bool is_edge() {
+    vec3 normal = oct_decode(LOAD(normal_attachment, 0).rg);
+    float depth = view_depth(LOAD(depth_attachment, 0).r);
+
+    for (int i = 1; i < int(sample_count); ++i) {
+        if (dot(oct_decode(LOAD(normal_attachment, i).rg), normal) < EDGE_NORMAL) return true;
+        if (abs(view_depth(LOAD(depth_attachment, i).r) - depth) > EDGE_DEPTH * depth) return true;
+    }
+
+    return false;
+}
+
+float view_depth(float depth) {
+    vec4 view_position = inv_proj * vec4(0.0, 0.0, depth, 1.0);
+    return -view_position.z / view_position.w;
+}
+#endif
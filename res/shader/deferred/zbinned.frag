@@ -0,0 +1,204 @@
+#version 450
+// MULTISAMPLED is defined by the build for the multisampled g-buffer permutation
+#ifdef MULTISAMPLED
+#define SUBPASS_INPUT subpassInputMS
+#define LOAD(attachment, sample_index) subpassLoad(attachment, sample_index)
+#else
+#define SUBPASS_INPUT subpassInput
+#define LOAD(attachment, sample_index) subpassLoad(attachment)
+#endif
+
+const float PI      = 3.14;
+const float EPSILON = 0.01;
+#ifdef MULTISAMPLED
+const float EDGE_NORMAL = 0.95; // min cosine between the normals of samples on one surface
+const float EDGE_DEPTH  = 0.01; // max view depth difference relative to the first sample
+#endif
+
+struct Light {
+    vec3 position;
+    float radius;
+    vec3 colour;
+    float curve;
+};
+
+layout(std140, set = 0, binding = 0) uniform Camera {
+    mat4 proj;
+    mat4 view;
+    mat4 inv_proj;
+    uvec2 screen_size;
+    float near;
+    float far;
+    vec3 eye;
+};
+
+layout(set = 1, input_attachment_index = 0, binding = 0) uniform SUBPASS_INPUT albedo_attachment;
+layout(set = 1, input_attachment_index = 1, binding = 1) uniform SUBPASS_INPUT normal_attachment;   // octahedral normal
+layout(set = 1, input_attachment_index = 2, binding = 2) uniform SUBPASS_INPUT material_attachment; // metallic + roughness
+layout(set = 1, input_attachment_index = 3, binding = 3) uniform SUBPASS_INPUT depth_attachment;    // position is reconstructed from depth
+
+layout(std430, set=2, binding=0) readonly buffer LightArray { uvec3 cluster_count; uint light_count; Light lights[]; };
+layout(std430, set=2, binding=2) readonly buffer TileMaskArray { uint masks[]; };
+layout(std430, set=2, binding=5) readonly buffer SortedArray { uint sorted[]; };
+layout(std430, set=2, binding=6) readonly buffer ZBinArray { uint zbins[]; };
+
+layout(location = 0) out vec4 out_colour;
+
+#ifdef MULTISAMPLED
+layout(push_constant) uniform Samples { uint sample_count; }; // of the g-buffer
+#endif
+
+vec3 F_Schlick(float HdotV, vec3 F0);
+float D_GGX(float NdotH, float r);
+float G_SchlickGGX(float NdotV, float roughness);
+float G_Smith(float NdotV, float NdotL, float roughness);
+float attenuate(vec3 light_position, vec3 frag_position, float radius, float curve);
+vec3 oct_decode(vec2 e);
+vec4 shade(int sample_index);
+#ifdef MULTISAMPLED
+bool is_edge();
+float view_depth(float depth);
+#endif
+vec3 reconstruct_position(float depth);
+
+void main() {
+#ifdef MULTISAMPLED
+    // pixels whose samples all see the same surface are shaded once, only edge pixels are shaded per sample
+    int count = is_edge() ? int(sample_count) : 1;
+
+    out_colour = vec4(0.0);
+    for (int i = 0; i < count; ++i) {
+        out_colour += shade(i);
+    }
+    out_colour /= float(count);
+#else
+    out_colour = shade(0);
+#endif
+}
+
+vec4 shade(int sample_index) {
+    vec4 in_albedo = LOAD(albedo_attachment, sample_index);
+    vec3 albedo = in_albedo.rgb;
+
+    vec3 normal = oct_decode(LOAD(normal_attachment, sample_index).rg);
+
+    vec2 in_material = LOAD(material_attachment, sample_index).rg;
+    float metallic = in_material.r;
+    float roughness = in_material.g;
+
+    vec3 frag_position = reconstruct_position(LOAD(depth_attachment, sample_index).r);
+
+    vec3 N = normalize(normal);
+    vec3 V = normalize(eye - frag_position);
+
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+    
+    // ambient component
+    vec4 colour = vec4(0.01 * albedo, 1.0);
+
+    uvec2 tilecoord = uvec2(gl_FragCoord) / ((screen_size.xy - 1) / cluster_count.xy + 1);
+    uint tile_index = tilecoord.x + tilecoord.y * cluster_count.x;
+    uint word_count = (light_count + 31) / 32;
+
+    // lights are sorted by depth, the z bin bounds the range of sorted lights and the tile mask picks from it
+    float depth = -(view * vec4(frag_position, 1.0)).z;
+    uint bin = min(uint(max(depth - near, 0.0) / (far - near) * ZBIN_COUNT), ZBIN_COUNT - 1);
+    uint first = zbins[bin] & 0xffff;
+    uint last = zbins[bin] >> 16;
+
+    for (uint word = first / 32; first <= last && word <= last / 32; ++word) {
+        uint mask = masks[tile_index * word_count + word];
+        if (word == first / 32) mask &= ~0u << (first % 32);
+        if (word == last / 32)  mask &= ~0u >> (31 - last % 32);
+
+        while (mask != 0) {
+            uint bit = findLSB(mask);
+            mask &= mask - 1;
+
+            Light light = lights[sorted[word * 32 + bit]];
+            vec3 L = normalize(light.position - frag_position);
+            vec3 H = normalize(V + L);
+
+            float NdotH = max(dot(N, H), EPSILON);
+            float NdotV = max(dot(N, V), EPSILON);
+            float NdotL = max(dot(N, L), EPSILON);
+            float HdotV = max(dot(H, V), EPSILON);
+        
+            float A = attenuate(light.position, frag_position, light.radius, light.curve); // attenuation
+            float D = D_GGX(NdotH, roughness);
+            float G = G_Smith(NdotV, NdotL, roughness);
+            vec3  F = F_Schlick(HdotV, F0);
+
+            vec3 diffuse = albedo / max(PI * (1.0 - metallic), EPSILON);
+            vec3 specular = D * G * F / max(4.0 * NdotV * NdotL, EPSILON);
+            colour.rgb += (diffuse + specular) * light.colour * A * NdotL;
+        }
+    }
+
+    return colour;
+}
+
+vec3 F_Schlick(float HdotV, vec3 F0) {
+    return F0 + (1.0 - F0) * pow(1.0 - HdotV, 5.0);
+}
+
+float D_GGX(float NdotH, float r) {
+    float a = r * r;
+    float a2 = a * a;
+    float d = (NdotH * (a2 - 1.0) + 1.0);
+    return a2 / max(PI * d * d, EPSILON);
+}
+
+float G_SchlickGGX(float NdotV, float roughness) {
+    float r = roughness + 1;
+    float k = r * r / 8.0;
+    return NdotV / max(NdotV * (1.0 - k) + k, EPSILON);
+}
+
+float G_Smith(float NdotV, float NdotL, float roughness) {
+    return G_SchlickGGX(NdotL, roughness) * G_SchlickGGX(NdotV, roughness);
+}
+
+float attenuate(vec3 light_position, vec3 frag_position, float radius, float curve) {
+    vec3 d = light_position - frag_position;    // difference
+    float d2 = dot(d, d);
+    float r2 = radius * radius;
+    return clamp(curve * max(r2 - d2, 0) / d2, 0, 1);
+}
+
+vec2 sign_not_zero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign_not_zero(n.xy);
+    return normalize(n);
+}
+
+vec3 reconstruct_position(float depth) { // world position of the fragment from its depth
+    vec2 screen = gl_FragCoord.xy / vec2(screen_size);
+    vec4 view_position = inv_proj * vec4(screen * 2.0 - 1.0, depth, 1.0);
+    view_position /= view_position.w;
+    return transpose(mat3(view)) * (view_position.xyz - view[3].xyz);
+}
+
+#ifdef MULTISAMPLED
+bool is_edge() {
+    vec3 normal = oct_decode(LOAD(normal_attachment, 0).rg);
+    float depth = view_depth(LOAD(depth_attachment, 0).r);
+
+    for (int i = 1; i < int(sample_count); ++i) {
+        if (dot(oct_decode(LOAD(normal_attachment, i).rg), normal) < EDGE_NORMAL) return true;
+        if (abs(view_depth(LOAD(depth_attachment, i).r) - depth) > EDGE_DEPTH * depth) return true;
+    }
+
+    return false;
+}
+
+float view_depth(float depth) {
+    vec4 view_position = inv_proj * vec4(0.0, 0.0, depth, 1.0);
+    return -view_position.z / view_position.w;
+}
+#endif
@@ -1,5 +1,5 @@
 #version 450
-#define MAX_LIGHTS_PER_CLUSTER 63
+#extension GL_EXT_nonuniform_qualifier : require
 
 const float PI      = 3.14;
 const float EPSILON = 0.01;
@@ -16,8 +16,8 @@ struct Frustum {
 };
 
 struct Cluster {
+    uint offset; // first entry in the light index list
     uint light_count;
-    uint indices[MAX_LIGHTS_PER_CLUSTER];
 };
 
 
@@ -32,24 +32,30 @@ layout (std140, set=0, binding=0) uniform Camera {
 };
 
 // layout (std140, set=1, binding=0) uniform Transform; 
-layout (std140, set=2, binding=0) uniform Material {
+
+struct Material {
     vec3 albedo;
     float metallic;
     float roughness;
     uint flags;
-} material;
-layout(set=2, binding=1) uniform sampler2D albedo_map;
-layout(set=2, binding=2) uniform sampler2D metallic_map;
-layout(set=2, binding=3) uniform sampler2D roughness_map;
-layout(set=2, binding=4) uniform sampler2D normal_map;
+    uint albedo_map;
+    uint metallic_map;
+    uint roughness_map;
+    uint normal_map;
+};
+
+layout(std430, set=2, binding=0) readonly buffer MaterialArray { Material materials[]; };
+layout(set=2, binding=1) uniform sampler2D textures[]; // bindless, indexed by the material's maps
 
 layout(std430, set=3, binding=0) readonly buffer LightArray { uvec3 cluster_count; uint light_count; Light lights[]; };
 layout(std430, set=3, binding=1) readonly buffer FrustumArray { Frustum frustums[]; };
 layout(std430, set=3, binding=2) readonly buffer ClusterArray { Cluster clusters[]; };
+layout(std430, set=3, binding=7) readonly buffer LightIndexArray { uint index_count; uint indices[]; }; // 16 bit light indices, packed in pairs
 
 layout(location = 0) in vec3 frag_position; // world position
 layout(location = 1) in vec2 frag_texcoord;
 layout(location = 2) in mat3 TBN;
+layout(location = 5) flat in uint frag_material;
 
 layout(location = 0) out vec4 out_colour;
 
@@ -66,16 +72,18 @@ float attenuate(vec3 light_position, vec3 frag_position, float radius, float cur
 float linearize_depth(float depth);
 
 void main() {
+    Material material = materials[frag_material];
+
     vec3 albedo;
     if ((material.flags & albedo_texture_flag) == albedo_texture_flag) {
-        albedo = texture(albedo_map, frag_texcoord).rgb;
+        albedo = texture(textures[material.albedo_map], frag_texcoord).rgb;
     } else {
         albedo = material.albedo;
     }
 
     vec3 normal;
     if ((material.flags & normal_texture_flag) == normal_texture_flag) {
-        normal = texture(normal_map, frag_texcoord).rgb * 2.0 - 1;
+        normal = texture(textures[material.normal_map], frag_texcoord).rgb * 2.0 - 1;
         normal = normalize(TBN * normal);
     } else {
         normal = TBN[2];
@@ -83,14 +91,14 @@ void main() {
 
     float metallic;
     if ((material.flags & metallic_texture_flag) == metallic_texture_flag) {
-        metallic = texture(metallic_map, frag_texcoord).r;
+        metallic = texture(textures[material.metallic_map], frag_texcoord).r;
     } else {
         metallic = material.metallic;
     }
 
     float roughness;
     if ((material.flags & roughness_texture_flag) == roughness_texture_flag) {
-        roughness = texture(roughness_map, frag_texcoord).r;
+        roughness = texture(textures[material.roughness_map], frag_texcoord).r;
     } else {
         roughness = material.roughness;
     }
@@ -113,9 +121,10 @@ void main() {
                          clusterID.y * cluster_count.x + 
                          clusterID.z * cluster_count.x * cluster_count.y;
 
-    for (uint i = 0; i < clusters[cluster_index].light_count; ++i) {
+    Cluster cluster = clusters[cluster_index];
+    for (uint i = cluster.offset; i < cluster.offset + cluster.light_count; ++i) {
         
-        Light light = lights[clusters[cluster_index].indices[i]];
+        Light light = lights[indices[i / 2] >> (i & 1) * 16 & 0xffff];
         vec3 L = normalize(light.position - frag_position);
         vec3 H = normalize(V + L);
 
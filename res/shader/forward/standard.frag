@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 struct Light {
     vec3 position;
@@ -18,17 +19,19 @@ layout (std140, set = 0, binding = 0) uniform Camera {
     vec3 eye;
 };
 
-layout (std140, set = 2, binding = 0) uniform Material {
+struct Material {
     vec3 albedo;
     float metallic;
     float roughness;
     uint flags;
-} material;
+    uint albedo_map;
+    uint metallic_map;
+    uint roughness_map;
+    uint normal_map;
+};
 
-layout(set = 2, binding = 1) uniform sampler2D albedo_map;
-layout(set = 2, binding = 2) uniform sampler2D metallic_map;
-layout(set = 2, binding = 3) uniform sampler2D roughness_map;
-layout(set = 2, binding = 4) uniform sampler2D normal_map;
+layout(std430, set = 2, binding = 0) readonly buffer MaterialArray { Material materials[]; };
+layout(set = 2, binding = 1) uniform sampler2D textures[]; // bindless, indexed by the material's maps
 
 layout(std430, set = 3, binding = 0) readonly buffer LightArray {
     uvec3 cluster_count;
@@ -39,6 +42,7 @@ layout(std430, set = 3, binding = 0) readonly buffer LightArray {
 layout(location = 0) in vec3 frag_position; // world position
 layout(location = 1) in vec2 frag_texcoord;
 layout(location = 2) in mat3 TBN;
+layout(location = 5) flat in uint frag_material;
 
 layout(location = 0) out vec4 out_colour;
 
@@ -57,16 +61,18 @@ float G_Smith(float NdotV, float NdotL, float roughness);
 float attenuate(vec3 light_position, vec3 frag_position, float radius, float curve);
 
 void main() {
+    Material material = materials[frag_material];
+
     vec3 albedo;
     if ((material.flags & albedo_texture_flag) == albedo_texture_flag) {
-        albedo = texture(albedo_map, frag_texcoord).rgb;
+        albedo = texture(textures[material.albedo_map], frag_texcoord).rgb;
     } else {
         albedo = material.albedo;
     }
 
     vec3 normal;
     if ((material.flags & normal_texture_flag) == normal_texture_flag) {
-        normal = texture(normal_map, frag_texcoord).rgb * 2.0 - 1.0;
+        normal = texture(textures[material.normal_map], frag_texcoord).rgb * 2.0 - 1.0;
         normal = normalize(TBN * normal);
     } else {
         normal = TBN[2];
@@ -74,14 +80,14 @@ void main() {
 
     float metallic;
     if ((material.flags & metallic_texture_flag) == metallic_texture_flag) {
-        metallic = texture(metallic_map, frag_texcoord).r;
+        metallic = texture(textures[material.metallic_map], frag_texcoord).r;
     } else {
         metallic = material.metallic;
     }
 
     float roughness;
     if ((material.flags & roughness_texture_flag) == roughness_texture_flag) {
-        roughness = texture(roughness_map, frag_texcoord).r;
+        roughness = texture(textures[material.roughness_map], frag_texcoord).r;
     } else {
         roughness = material.roughness;
     }
@@ -1,6 +1,5 @@
 #version 450
-#define TILE_SIZE 16
-#define MAX_LIGHTS_PER_TILE 127
+#extension GL_EXT_nonuniform_qualifier : require
 
 const float PI      = 3.14;
 const float EPSILON = 0.01;
@@ -12,15 +11,6 @@ struct Light {
     float curve;
 };
 
-struct Frustum {
-    vec4 planes[4];
-};
-
-struct Cluster {
-    uint light_count;
-    uint indices[MAX_LIGHTS_PER_TILE];
-};
-
 
 layout (std140, set=0, binding=0) uniform Camera {
     mat4 proj;
@@ -33,24 +23,28 @@ layout (std140, set=0, binding=0) uniform Camera {
 };
 
 // layout (std140, set=1, binding=0) uniform Transform; 
-layout (std140, set=2, binding=0) uniform Material {
+
+struct Material {
     vec3 albedo;
     float metallic;
     float roughness;
     uint flags;
-} material;
-layout(set=2, binding=1) uniform sampler2D albedo_map;
-layout(set=2, binding=2) uniform sampler2D metallic_map;
-layout(set=2, binding=3) uniform sampler2D roughness_map;
-layout(set=2, binding=4) uniform sampler2D normal_map;
+    uint albedo_map;
+    uint metallic_map;
+    uint roughness_map;
+    uint normal_map;
+};
+
+layout(std430, set=2, binding=0) readonly buffer MaterialArray { Material materials[]; };
+layout(set=2, binding=1) uniform sampler2D textures[]; // bindless, indexed by the material's maps
 
 layout(std430, set=3, binding=0) readonly buffer LightArray { uvec3 cluster_count; uint light_count; Light lights[]; };
-layout(std430, set=3, binding=1) readonly buffer FrustumArray { Frustum frustums[]; };
-layout(std430, set=3, binding=2) readonly buffer ClusterArray { Cluster clusters[]; };
+layout(std430, set=3, binding=2) readonly buffer TileMaskArray { uint masks[]; }; // 1 bit per light
 
 layout(location = 0) in vec3 frag_position; // world position
 layout(location = 1) in vec2 frag_texcoord;
 layout(location = 2) in mat3 TBN;
+layout(location = 5) flat in uint frag_material;
 
 layout(location = 0) out vec4 out_colour;
 
@@ -66,16 +60,18 @@ float G_Smith(float NdotV, float NdotL, float roughness);
 float attenuate(vec3 light_position, vec3 frag_position, float radius, float curve);
 
 void main() {
+    Material material = materials[frag_material];
+
     vec3 albedo;
     if ((material.flags & albedo_texture_flag) == albedo_texture_flag) {
-        albedo = texture(albedo_map, frag_texcoord).rgb;
+        albedo = texture(textures[material.albedo_map], frag_texcoord).rgb;
     } else {
         albedo = material.albedo;
     }
 
     vec3 normal;
     if ((material.flags & normal_texture_flag) == normal_texture_flag) {
-        normal = texture(normal_map, frag_texcoord).rgb * 2.0 - 1.0;
+        normal = texture(textures[material.normal_map], frag_texcoord).rgb * 2.0 - 1.0;
         normal = normalize(TBN * normal);
     } else {
         normal = TBN[2];
@@ -83,14 +79,14 @@ void main() {
 
     float metallic;
     if ((material.flags & metallic_texture_flag) == metallic_texture_flag) {
-        metallic = texture(metallic_map, frag_texcoord).r;
+        metallic = texture(textures[material.metallic_map], frag_texcoord).r;
     } else {
         metallic = material.metallic;
     }
 
     float roughness;
     if ((material.flags & roughness_texture_flag) == roughness_texture_flag) {
-        roughness = texture(roughness_map, frag_texcoord).r;
+        roughness = texture(textures[material.roughness_map], frag_texcoord).r;
     } else {
         roughness = material.roughness;
     }
@@ -105,26 +101,32 @@ void main() {
     out_colour = vec4(0.01 * albedo, 1.0);
     
     uvec2 tilecoord = uvec2(gl_FragCoord) / ((screen_size.xy - 1) / cluster_count.xy + 1);
-    uint cluster_index = tilecoord.x + tilecoord.y * cluster_count.x;
-    for (uint i = 0; i < clusters[cluster_index].light_count; ++i) {
-        
-        Light light = lights[clusters[cluster_index].indices[i]];
-        vec3 L = normalize(light.position - frag_position);
-        vec3 H = normalize(V + L);
-
-        float NdotH = max(dot(N, H), EPSILON);
-        float NdotV = max(dot(N, V), EPSILON);
-        float NdotL = max(dot(N, L), EPSILON);
-        float HdotV = max(dot(H, V), EPSILON);
+    uint tile_index = tilecoord.x + tilecoord.y * cluster_count.x;
+    uint word_count = (light_count + 31) / 32;
+    for (uint word = 0; word < word_count; ++word) {
+        uint mask = masks[tile_index * word_count + word];
+        while (mask != 0) {
+            uint bit = findLSB(mask);
+            mask &= mask - 1;
+
+            Light light = lights[word * 32 + bit];
+            vec3 L = normalize(light.position - frag_position);
+            vec3 H = normalize(V + L);
+
+            float NdotH = max(dot(N, H), EPSILON);
+            float NdotV = max(dot(N, V), EPSILON);
+            float NdotL = max(dot(N, L), EPSILON);
+            float HdotV = max(dot(H, V), EPSILON);
         
-        float A = attenuate(light.position, frag_position, light.radius, light.curve); // attenuation
-        float D = D_GGX(NdotH, roughness);
-        float G = G_Smith(NdotV, NdotL, roughness);
-        vec3  F = F_Schlick(HdotV, F0);
-
-        vec3 diffuse = albedo / max(PI * (1.0 - metallic), EPSILON);
-        vec3 specular = D * G * F / max(4.0 * NdotV * NdotL, EPSILON);
-        out_colour.rgb += (diffuse + specular) * light.colour * A * NdotL;
+            float A = attenuate(light.position, frag_position, light.radius, light.curve); // attenuation
+            float D = D_GGX(NdotH, roughness);
+            float G = G_Smith(NdotV, NdotL, roughness);
+            vec3  F = F_Schlick(HdotV, F0);
+
+            vec3 diffuse = albedo / max(PI * (1.0 - metallic), EPSILON);
+            vec3 specular = D * G * F / max(4.0 * NdotV * NdotL, EPSILON);
+            out_colour.rgb += (diffuse + specular) * light.colour * A * NdotL;
+        }
     }   
 }
 
@@ -10,14 +10,19 @@ layout (std140, set=0, binding=0) uniform Camera {
     vec3 eye;
 };
 
-layout (set=1, binding=0) uniform Transform {
+struct Instance {
     mat4 model;
+    vec4 sphere;
+    uint mesh;
+    uint material;
 };
 
+layout (std430, set=1, binding=0) readonly buffer InstanceArray { Instance instances[]; };
+
 layout(location = 0) in vec3 in_position;
 
 void main() {
-    mat4 mvp = proj * view * model;
+    mat4 mvp = proj * view * instances[gl_InstanceIndex].model;
     gl_Position = mvp * vec4(in_position, 1.0);
 
 }
\ No newline at end of file
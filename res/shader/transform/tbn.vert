@@ -10,10 +10,16 @@ layout (std140, set=0, binding=0) uniform Camera {
     float far;
     vec3 eye;
 };
-layout (set=1, binding=0) uniform Transform {
+struct Instance {
     mat4 model;
+    vec4 sphere;
+    uint mesh;
+    uint material;
 };
 
+// indexed by the first instance of the draw command written by instance culling
+layout (std430, set=1, binding=0) readonly buffer InstanceArray { Instance instances[]; };
+
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec2 in_texcoord;
 layout(location = 2) in vec3 in_normal;
@@ -23,9 +29,13 @@ layout(location = 4) in vec3 in_bi_tangent;
 layout(location = 0) out vec3 frag_position;
 layout(location = 1) out vec2 frag_texcoord;
 layout(location = 2) out mat3 frag_TBN;
+layout(location = 5) flat out uint frag_material;
 
 
 void main() {
+    mat4 model = instances[gl_InstanceIndex].model;
+    frag_material = instances[gl_InstanceIndex].material;
+
     gl_Position = proj * view * model * vec4(in_position, 1.0);
 
     frag_position = vec3(model * vec4(in_position, 1.0));
@@ -0,0 +1,31 @@
+#version 450
+
+layout (std140, set=0, binding=0) uniform Camera {
+    mat4 proj;
+    mat4 view;
+    mat4 inv_proj;
+    uvec2 screen_size;
+    float near;
+    float far;
+    vec3 eye;
+};
+
+struct Instance {
+    mat4 model;
+    vec4 sphere;
+    uint mesh;
+    uint material;
+};
+
+layout (std430, set=1, binding=0) readonly buffer InstanceArray { Instance instances[]; };
+
+layout(location = 0) in vec3 in_position;
+
+layout(location = 0) flat out uint frag_instance;
+
+void main() {
+    mat4 mvp = proj * view * instances[gl_InstanceIndex].model;
+    gl_Position = mvp * vec4(in_position, 1.0);
+
+    frag_instance = gl_InstanceIndex;
+}
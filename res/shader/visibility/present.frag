@@ -0,0 +1,241 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+#define VERTEX_STRIDE 14 // floats per vertex
+
+struct Light {
+    vec3 position;
+    float radius;
+    vec3 colour;
+    float curve;
+};
+
+layout (std140, set = 0, binding = 0) uniform Camera {
+    mat4 proj;
+    mat4 view;
+    mat4 inv_proj;
+    uvec2 screen_size;
+    float near;
+    float far;
+    vec3 eye;
+};
+
+struct Material {
+    vec3 albedo;
+    float metallic;
+    float roughness;
+    uint flags;
+    uint albedo_map;
+    uint metallic_map;
+    uint roughness_map;
+    uint normal_map;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer MaterialArray { Material materials[]; };
+layout(set = 2, binding = 1) uniform sampler2D textures[]; // bindless, indexed by the material's maps. materials vary per pixel, the index is nonuniform
+
+layout(std430, set = 3, binding = 0) readonly buffer LightArray {
+    uvec3 cluster_count;
+    uint light_count;
+    Light lights[];
+};
+
+struct Instance {
+    mat4 model;
+    vec4 sphere;
+    uint mesh;
+    uint material;
+};
+
+struct Mesh {
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint meshlet_offset;
+    uint meshlet_count;
+};
+
+struct Vertex {
+    vec3 position;
+    vec2 texcoord;
+    vec3 normal;
+    vec3 tangent;
+    vec3 bi_tangent;
+};
+
+layout(set = 1, input_attachment_index = 0, binding = 0) uniform usubpassInput visibility_attachment; // instance + triangle
+
+// geometry of the visible triangles, fetched per pixel
+layout(std430, set = 4, binding = 0) readonly buffer InstanceArray { Instance instances[]; };
+layout(std430, set = 4, binding = 1) readonly buffer MeshArray { Mesh meshes[]; };
+layout(std430, set = 4, binding = 2) readonly buffer VertexArray { float vertices[]; }; // tightly packed vertex attributes
+layout(std430, set = 4, binding = 3) readonly buffer IndexArray { uint mesh_indices[]; };
+
+layout(location = 0) out vec4 out_colour;
+
+const uint albedo_texture_flag = 0x00000001;
+const uint metallic_texture_flag = 0x00000002;
+const uint roughness_texture_flag = 0x00000004;
+const uint normal_texture_flag = 0x00000008;
+const uint no_instance = 0xffffffff;
+
+const float PI      = 3.14;
+const float EPSILON = 0.01;
+
+vec3 F_Schlick(float HdotV, vec3 F0);
+float D_GGX(float NdotH, float r);
+float G_SchlickGGX(float NdotV, float roughness);
+float G_Smith(float NdotV, float NdotL, float roughness);
+float attenuate(vec3 light_position, vec3 frag_position, float radius, float curve);
+Vertex fetch_vertex(uint index);
+vec3 barycentrics(vec2 pixel, vec3 p0, vec3 p1, vec3 p2);
+
+void main() {
+    uvec2 visibility = subpassLoad(visibility_attachment).rg;
+    if (visibility.x == no_instance) discard;
+
+    Instance instance = instances[visibility.x];
+    Mesh mesh = meshes[instance.mesh];
+
+    Vertex v[3];
+    vec3 p[3];
+    for (uint i = 0; i < 3; ++i) {
+        v[i] = fetch_vertex(uint(int(mesh_indices[mesh.first_index + visibility.y * 3 + i]) + mesh.vertex_offset));
+        p[i] = vec3(instance.model * vec4(v[i].position, 1.0));
+    }
+
+    // implicit derivatives are undefined here, a quad's pixels may resolve different triangles and sampling is
+    // in non uniform control flow. texcoord derivatives come from the neighbouring pixels on this triangle instead
+    vec3 lambda = barycentrics(gl_FragCoord.xy, p[0], p[1], p[2]);
+    vec3 lambda_dx = barycentrics(gl_FragCoord.xy + vec2(1.0, 0.0), p[0], p[1], p[2]) - lambda;
+    vec3 lambda_dy = barycentrics(gl_FragCoord.xy + vec2(0.0, 1.0), p[0], p[1], p[2]) - lambda;
+
+    vec3 frag_position = lambda.x * p[0] + lambda.y * p[1] + lambda.z * p[2];
+    vec2 frag_texcoord = lambda.x * v[0].texcoord + lambda.y * v[1].texcoord + lambda.z * v[2].texcoord;
+    vec2 texcoord_dx = lambda_dx.x * v[0].texcoord + lambda_dx.y * v[1].texcoord + lambda_dx.z * v[2].texcoord;
+    vec2 texcoord_dy = lambda_dy.x * v[0].texcoord + lambda_dy.y * v[1].texcoord + lambda_dy.z * v[2].texcoord;
+    mat3 norm_mat = transpose(inverse(mat3(instance.model)));
+    mat3 TBN = mat3(
+        norm_mat * (lambda.x * v[0].tangent    + lambda.y * v[1].tangent    + lambda.z * v[2].tangent),
+        norm_mat * (lambda.x * v[0].bi_tangent + lambda.y * v[1].bi_tangent + lambda.z * v[2].bi_tangent),
+        norm_mat * (lambda.x * v[0].normal     + lambda.y * v[1].normal     + lambda.z * v[2].normal)
+    );
+    uint frag_material = instance.material;
+
+    Material material = materials[frag_material];
+
+    vec3 albedo;
+    if ((material.flags & albedo_texture_flag) == albedo_texture_flag) {
+        albedo = textureGrad(textures[nonuniformEXT(material.albedo_map)], frag_texcoord, texcoord_dx, texcoord_dy).rgb;
+    } else {
+        albedo = material.albedo;
+    }
+
+    vec3 normal;
+    if ((material.flags & normal_texture_flag) == normal_texture_flag) {
+        normal = textureGrad(textures[nonuniformEXT(material.normal_map)], frag_texcoord, texcoord_dx, texcoord_dy).rgb * 2.0 - 1.0;
+        normal = normalize(TBN * normal);
+    } else {
+        normal = TBN[2];
+    }
+
+    float metallic;
+    if ((material.flags & metallic_texture_flag) == metallic_texture_flag) {
+        metallic = textureGrad(textures[nonuniformEXT(material.metallic_map)], frag_texcoord, texcoord_dx, texcoord_dy).r;
+    } else {
+        metallic = material.metallic;
+    }
+
+    float roughness;
+    if ((material.flags & roughness_texture_flag) == roughness_texture_flag) {
+        roughness = textureGrad(textures[nonuniformEXT(material.roughness_map)], frag_texcoord, texcoord_dx, texcoord_dy).r;
+    } else {
+        roughness = material.roughness;
+    }
+
+    vec3 N = normalize(normal);
+    vec3 V = normalize(eye - frag_position);
+
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+    
+    // ambient component
+    out_colour = vec4(0.01 * albedo, 1.0);
+
+    // for each light
+    for (uint i = 0; i < light_count; ++i) {
+        Light light = lights[i];
+        
+        vec3 L = normalize(light.position - frag_position);
+        vec3 H = normalize(V + L);
+
+        float NdotH = max(dot(N, H), EPSILON);
+        float NdotV = max(dot(N, V), EPSILON);
+        float NdotL = max(dot(N, L), EPSILON);
+        float HdotV = max(dot(H, V), EPSILON);
+        
+        float A = attenuate(light.position, frag_position, light.radius, light.curve); // attenuation
+        float D = D_GGX(NdotH, roughness);
+        float G = G_Smith(NdotV, NdotL, roughness);
+        vec3  F = F_Schlick(HdotV, F0);
+
+        vec3 diffuse = albedo / PI * (1.0 - metallic);
+        vec3 specular = D * G * F / max(4.0 * NdotV * NdotL, EPSILON);
+        out_colour.rgb += (diffuse + specular) * light.colour * A * NdotL;
+    }
+}
+
+vec3 F_Schlick(float HdotV, vec3 F0) {
+    return F0 + (1.0 - F0) * pow(1.0 - HdotV, 5.0);
+}
+
+float D_GGX(float NdotH, float r) {
+    float a = r * r;
+    float a2 = a * a;
+    float d = (NdotH * (a2 - 1.0) + 1.0);
+    return a2 / max(PI * d * d, EPSILON);
+}
+
+float G_SchlickGGX(float NdotV, float roughness) {
+    float r = roughness + 1;
+    float k = r * r / 8.0;
+    return NdotV / max(NdotV * (1.0 - k) + k, EPSILON);
+}
+
+float G_Smith(float NdotV, float NdotL, float roughness) {
+    return G_SchlickGGX(NdotL, roughness) * G_SchlickGGX(NdotV, roughness);
+}
+
+float attenuate(vec3 light_position, vec3 frag_position, float radius, float curve) {
+    vec3 d = light_position - frag_position;    // difference
+    float d2 = dot(d, d);
+    float r2 = radius * radius;
+    return clamp(curve * max(r2 - d2, 0) / d2, 0, 1);
+}
+
+Vertex fetch_vertex(uint index) {
+    uint base = index * VERTEX_STRIDE;
+
+    Vertex vertex;
+    vertex.position   = vec3(vertices[base +  0], vertices[base +  1], vertices[base +  2]);
+    vertex.texcoord   = vec2(vertices[base +  3], vertices[base +  4]);
+    vertex.normal     = vec3(vertices[base +  5], vertices[base +  6], vertices[base +  7]);
+    vertex.tangent    = vec3(vertices[base +  8], vertices[base +  9], vertices[base + 10]);
+    vertex.bi_tangent = vec3(vertices[base + 11], vertices[base + 12], vertices[base + 13]);
+    return vertex;
+}
+
+vec3 barycentrics(vec2 pixel, vec3 p0, vec3 p1, vec3 p2) { // where the eye ray through the pixel hits the triangle's plane
+    vec2 screen = pixel / vec2(screen_size);
+    vec4 view_position = inv_proj * vec4(screen * 2.0 - 1.0, 1.0, 1.0);
+    vec3 direction = transpose(mat3(view)) * (view_position.xyz / view_position.w);
+
+    vec3 e1 = p1 - p0;
+    vec3 e2 = p2 - p0;
+    vec3 s = cross(direction, e2);
+    vec3 t = eye - p0;
+    float det = dot(e1, s);
+
+    float u = dot(t, s) / det;
+    float v = dot(direction, cross(t, e1)) / det;
+    return vec3(1.0 - u - v, u, v);
+}
@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) flat in uint frag_instance;
+
+layout(location = 0) out uvec2 out_visibility; // instance + triangle of the mesh, cleared to ~0 where nothing is drawn
+
+// gl_PrimitiveID counts from the draw's first index, only whole mesh draws give the triangle of the mesh.
+// meshlet draws start part way through the mesh's indices and are not drawn into the visibility buffer
+
+void main() {
+    out_visibility = uvec2(frag_instance, gl_PrimitiveID);
+}
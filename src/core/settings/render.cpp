@@ -1,11 +1,15 @@
 #include <core/settings/render.h>
 
-Arawn::RenderMode::RenderMode(Json::Boolean deferEnabled) : data(0) {
-    if (deferEnabled) { data = DEFERRED; } else { data = FORWARD; }
+Arawn::RenderMode::RenderMode(Json::String str) : data(0) {
+    if (str == "forward") { data = FORWARD; } else
+    if (str == "deferred") { data = DEFERRED; } else
+    if (str == "visibility") { data = VISIBILITY; }
 }
 Arawn::CullingMode::CullingMode(Json::String str) : data(0) {
-    if (str == "tile") { data = TILE; } else
-    if (str == "cluster") { data = CLUSTER; }
+    if (str == "tile" || str == "tiled") { data = TILE; } else
+    if (str == "cluster" || str == "clustered") { data = CLUSTER; } else
+    if (str == "zbin" || str == "zbinned") { data = ZBIN; } else
+    if (str == "tile 2.5d" || str == "tiled 2.5d") { data = TILE_25D; }
 }
 Arawn::DepthMode::DepthMode(Json::Boolean depthEnabled) : data(0) {
             if (depthEnabled) { data = ENABLED; } else { data = DISABLED; } 
@@ -0,0 +1,157 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/culling.h>
+#include <algorithm>
+
+using namespace Arawn;
+
+constexpr uint32_t averageLightsPerCluster = 32; // sizes the light index list, clusters past it are truncated
+constexpr uint64_t lightHeaderSize = 16;         // uvec3 cluster_count, uint light_count
+constexpr uint64_t clusterSize = 8;              // offset + light count
+constexpr uint64_t maxUpdateSize = 65536;        // largest vkCmdUpdateBuffer
+
+static_assert(sizeof(Light) == 32, "light must match the std430 shader layout");
+
+ClusterCulling::ClusterCulling(FrustumGrid& grid, Pipelines& pipelines, uint32_t slices, uint32_t capacity)
+ : grid(grid), pipelines(pipelines), slices(slices), capacity(capacity), projection{}, width(0), height(0),
+   lightBuffer(UINT32_MAX), binBuffer(UINT32_MAX), clusterBuffer(UINT32_MAX), indexBuffer(UINT32_MAX),
+   frustum(nullptr), bin(nullptr), cluster(nullptr)
+{
+    if (slices == 0 || slices > MAX_DEPTH_SLICES) throw std::runtime_error("cluster slices exceed MAX_DEPTH_SLICES");
+    if (capacity > MAX_LIGHTS) throw std::runtime_error("light capacity exceeds MAX_LIGHTS");
+}
+
+void ClusterCulling::update(const std::vector<Light>& lights, const float proj[16]) {
+    if (lights.size() > capacity) throw std::runtime_error("light buffer is full");
+
+    data = lights;
+    std::copy(proj, proj + 16, projection);
+}
+
+void ClusterCulling::declare(Render::Builder& builder, uint32_t width, uint32_t height, Camera camera) {
+    this->width = width;
+    this->height = height;
+    this->camera = std::move(camera);
+
+    frustum = &pipelines.get({ Program::permutation("cull/frustum.comp"), "", "", {} });
+    bin = &pipelines.get({ Program::permutation("cull/bin.comp"), "", "", {} });
+    cluster = &pipelines.get({ Program::permutation("cull/clustered.comp"), "", "", {} });
+
+    uint32_t tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32_t tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    uint32_t bins = (tilesX + BIN_SIZE - 1) / BIN_SIZE * ((tilesY + BIN_SIZE - 1) / BIN_SIZE);
+    uint64_t clusterCount = static_cast<uint64_t>(tilesX) * tilesY * slices;
+
+    { // every frame in flight has its own copy, so frame N+1 is written while frame N is read
+        lightBuffer = builder.buffer(lightHeaderSize + capacity * sizeof(Light), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        binBuffer = builder.buffer(bins * (1 + MAX_LIGHTS_PER_BIN) * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        clusterBuffer = builder.buffer(clusterCount * clusterSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        indexBuffer = builder.buffer(sizeof(uint32_t) + clusterCount * averageLightsPerCluster / 2 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT); // 16 bit indices in pairs
+    }
+
+    // contents are rebuilt every frame, nothing written by an earlier frame is kept
+    builder.task(ASYNC, [this](const Render::Task::Context& context) { record(context); })
+        .use(lightBuffer, Buffer::Usage{ VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ATTACHMENT_LOAD_OP_DONT_CARE })
+        .use(binBuffer, Buffer::Usage{ VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ATTACHMENT_LOAD_OP_DONT_CARE })
+        .use(clusterBuffer, Buffer::Usage{ VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ATTACHMENT_LOAD_OP_DONT_CARE })
+        .use(indexBuffer, Buffer::Usage{ VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ATTACHMENT_LOAD_OP_DONT_CARE });
+}
+
+uint32_t ClusterCulling::lights() const {
+    return lightBuffer;
+}
+
+uint32_t ClusterCulling::clusters() const {
+    return clusterBuffer;
+}
+
+uint32_t ClusterCulling::indices() const {
+    return indexBuffer;
+}
+
+void ClusterCulling::record(const Render::Task::Context& context) const {
+    VkBuffer lights = context.graph.buffer(lightBuffer, context.frameIndex);
+    VkBuffer bins = context.graph.buffer(binBuffer, context.frameIndex);
+    VkBuffer clusters = context.graph.buffer(clusterBuffer, context.frameIndex);
+    VkBuffer indices = context.graph.buffer(indexBuffer, context.frameIndex);
+
+    camera(context, *frustum);
+    grid.update(context, *frustum, projection, width, height, TILE_SIZE);
+
+    uint32_t tilesX = grid.tilesX();
+    uint32_t tilesY = grid.tilesY();
+
+    { // copy the lights into the frame's buffer, recorded inline so no staging memory outlives the frame
+        uint32_t header[4] = { tilesX, tilesY, slices, static_cast<uint32_t>(data.size()) };
+        vkCmdUpdateBuffer(context.cmd, lights, 0, sizeof(header), header);
+
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+        uint64_t size = data.size() * sizeof(Light);
+        for (uint64_t offset = 0; offset < size; offset += maxUpdateSize) {
+            vkCmdUpdateBuffer(context.cmd, lights, lightHeaderSize + offset, std::min(maxUpdateSize, size - offset), bytes + offset);
+        }
+
+        VkBufferMemoryBarrier barrier {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = lights,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        };
+
+        vkCmdPipelineBarrier(context.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    VkDescriptorBufferInfo infos[8] {
+        { lights, 0, VK_WHOLE_SIZE },
+        { grid.buffer(context), 0, VK_WHOLE_SIZE },
+        { clusters, 0, VK_WHOLE_SIZE },
+        {},
+        { bins, 0, VK_WHOLE_SIZE },
+        {}, {},
+        { indices, 0, VK_WHOLE_SIZE }
+    };
+
+    // binds the given bindings of the light culling set
+    auto bind = [&](const Program& program, std::initializer_list<uint32_t> bindings) {
+        VkDescriptorSet descriptorSet = context.descriptor(program, 1);
+
+        std::vector<VkWriteDescriptorSet> writes;
+        for (uint32_t binding : bindings) {
+            writes.push_back({
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSet,
+                .dstBinding = binding,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &infos[binding]
+            });
+        }
+        vkUpdateDescriptorSets(engine.device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        vkCmdBindPipeline(context.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program.pipeline);
+        camera(context, program);
+        vkCmdBindDescriptorSets(context.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program.layout, 1, 1, &descriptorSet, 0, nullptr);
+    };
+
+    { // bin lights into coarse screen tiles, also resets the light index list
+        bind(*bin, { 0, 1, 4, 7 });
+        vkCmdDispatch(context.cmd, (tilesX + BIN_SIZE - 1) / BIN_SIZE, (tilesY + BIN_SIZE - 1) / BIN_SIZE, 1);
+
+        VkMemoryBarrier barrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        };
+
+        vkCmdPipelineBarrier(context.cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    { // cull each tile's bin into its depth slices, the graph orders the writes before shading
+        bind(*cluster, { 0, 1, 2, 4, 7 });
+        vkCmdDispatch(context.cmd, tilesX, tilesY, 1);
+    }
+}
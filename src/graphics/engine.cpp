@@ -6,12 +6,21 @@
 
 #include <vector>
 #include <algorithm>
+#include <numeric>
 #include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
 
 #ifndef VULKAN_VERSION
 #define VULKAN_VERSION VK_API_VERSION_1_2
 #endif 
 
+#ifndef PIPELINE_CACHE_PATH
+#define PIPELINE_CACHE_PATH "cfg/pipeline.cache"
+#endif
+
 #ifdef ARAWN_DEBUG
 std::vector<const char*> instanceLayers = { "VK_LAYER_KHRONOS_validation" };
 std::vector<const char*> deviceLayers = { "VK_LAYER_KHRONOS_validation" };
@@ -20,37 +29,121 @@ std::vector<const char*> deviceLayers = { "VK_LAYER_KHRONOS_validation" };
 std::vector<const char*> instanceExtensions = { VK_KHR_SURFACE_EXTENSION_NAME };
 std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
-struct Arawn::DescriptorLayoutInfo {
-	friend bool operator==(const DescriptorLayoutInfo& lhs, const DescriptorLayoutInfo& rhs) {
-		if (lhs.bindings.size() != rhs.bindings.size()) {
-			return false;
-		}
-		
-		for (size_t i = 0; i < lhs.bindings.size(); ++i) {
-			if (lhs.bindings[i].binding != rhs.bindings[i].binding) return false;
-			if (lhs.bindings[i].descriptorType != rhs.bindings[i].descriptorType) return false;
-			if (lhs.bindings[i].descriptorCount != rhs.bindings[i].descriptorCount) return false;
-		}
-
-		return true;
-	}
-
-	friend auto operator<=>(const DescriptorLayoutInfo& lhs, const DescriptorLayoutInfo& rhs) {
-		if (lhs.bindings.size() != rhs.bindings.size()) return lhs.bindings.size() <=> rhs.bindings.size();
-
-		for (size_t i = 0; i < lhs.bindings.size(); ++i) {
-			if (lhs.bindings[i].binding != rhs.bindings[i].binding) return lhs.bindings[i].binding <=> rhs.bindings[i].binding;
-			if (lhs.bindings[i].descriptorType != rhs.bindings[i].descriptorType) return lhs.bindings[i].descriptorType <=> rhs.bindings[i].descriptorType;
-			if (lhs.bindings[i].descriptorCount != rhs.bindings[i].descriptorCount) return lhs.bindings[i].descriptorCount <=> rhs.bindings[i].descriptorCount;
-		}
-
-		return std::strong_ordering::equivalent;
-	}
-
-	std::vector<VkDescriptorSetLayoutBinding> bindings;
+// prefixed to the cache data on disk, the driver version is not part of vulkan's own cache header
+struct PipelineCacheHeader {
+    uint32_t magic;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t uuid[VK_UUID_SIZE];
+    uint64_t size;
+};
+
+constexpr uint32_t pipelineCacheMagic = 0x41525043; // "ARPC"
+
+static PipelineCacheHeader pipelineCacheHeader(VkPhysicalDevice gpu, uint64_t size) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(gpu, &properties);
+
+    PipelineCacheHeader header{
+        .magic = pipelineCacheMagic,
+        .vendorID = properties.vendorID,
+        .deviceID = properties.deviceID,
+        .driverVersion = properties.driverVersion,
+        .size = size
+    };
+    std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
+
+// descriptor set layout key, immutable samplers are copied so the key does not point into caller memory
+struct DescriptorLayoutInfo {
+    std::vector<VkDescriptorSetLayoutBinding> bindings; // sorted by binding, pImmutableSamplers is only compared as set or unset
+    std::vector<VkSampler> samplers;                    // immutable samplers of every binding in order
+    std::vector<VkDescriptorBindingFlags> flags;        // per sorted binding, empty if no binding has flags
+
+    friend bool operator==(const DescriptorLayoutInfo& lhs, const DescriptorLayoutInfo& rhs) {
+        if (lhs.bindings.size() != rhs.bindings.size() || lhs.samplers != rhs.samplers || lhs.flags != rhs.flags) {
+            return false;
+        }
+
+        for (size_t i = 0; i < lhs.bindings.size(); ++i) {
+            if (lhs.bindings[i].binding != rhs.bindings[i].binding) return false;
+            if (lhs.bindings[i].descriptorType != rhs.bindings[i].descriptorType) return false;
+            if (lhs.bindings[i].descriptorCount != rhs.bindings[i].descriptorCount) return false;
+            if (lhs.bindings[i].stageFlags != rhs.bindings[i].stageFlags) return false;
+            if ((lhs.bindings[i].pImmutableSamplers == nullptr) != (rhs.bindings[i].pImmutableSamplers == nullptr)) return false;
+        }
+
+        return true;
+    }
+};
+
+struct PipelineLayoutInfo {
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    std::vector<VkPushConstantRange> ranges;
+
+    friend bool operator==(const PipelineLayoutInfo& lhs, const PipelineLayoutInfo& rhs) {
+        if (lhs.setLayouts != rhs.setLayouts || lhs.ranges.size() != rhs.ranges.size()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < lhs.ranges.size(); ++i) {
+            if (lhs.ranges[i].stageFlags != rhs.ranges[i].stageFlags) return false;
+            if (lhs.ranges[i].offset != rhs.ranges[i].offset) return false;
+            if (lhs.ranges[i].size != rhs.ranges[i].size) return false;
+        }
+
+        return true;
+    }
+};
+
+static void hashCombine(std::size_t& seed, uint64_t value) {
+    seed ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+struct LayoutHash {
+    std::size_t operator()(const DescriptorLayoutInfo& info) const {
+        std::size_t seed = info.bindings.size();
+        for (const VkDescriptorSetLayoutBinding& binding : info.bindings) {
+            hashCombine(seed, binding.binding);
+            hashCombine(seed, binding.descriptorType);
+            hashCombine(seed, binding.descriptorCount);
+            hashCombine(seed, binding.stageFlags);
+        }
+        for (VkSampler sampler : info.samplers) {
+            hashCombine(seed, reinterpret_cast<uint64_t>(sampler));
+        }
+        for (VkDescriptorBindingFlags flags : info.flags) {
+            hashCombine(seed, flags);
+        }
+        return seed;
+    }
+
+    std::size_t operator()(const PipelineLayoutInfo& info) const {
+        std::size_t seed = info.setLayouts.size();
+        for (VkDescriptorSetLayout setLayout : info.setLayouts) {
+            hashCombine(seed, reinterpret_cast<uint64_t>(setLayout));
+        }
+        for (const VkPushConstantRange& range : info.ranges) {
+            hashCombine(seed, range.stageFlags);
+            hashCombine(seed, range.offset);
+            hashCombine(seed, range.size);
+        }
+        return seed;
+    }
+};
+
+// lookups take a shared lock, layouts are created outside the lock and the loser of an insert race destroys its copy
+struct Arawn::LayoutCache {
+    std::shared_mutex setMutex, pipelineMutex;
+    std::unordered_map<DescriptorLayoutInfo, VkDescriptorSetLayout, LayoutHash> setLayouts;
+    std::unordered_map<PipelineLayoutInfo, VkPipelineLayout, LayoutHash> pipelineLayouts;
+    std::atomic<uint64_t> setHits = 0, setMisses = 0, pipelineHits = 0, pipelineMisses = 0;
 };
 
 Arawn::Engine::Engine()
+ : layouts(std::make_unique<LayoutCache>())
 {
     { // init glfw
         GLFW_ASSERT(glfwInit() == GLFW_TRUE);
@@ -218,13 +311,13 @@ Arawn::Engine::Engine()
     }
 
     { // check device feature support
-        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{ 
-            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES, 
+        VkPhysicalDeviceVulkan12Features vulkan12Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
             .pNext = nullptr
         };
         VkPhysicalDeviceFeatures2 supported{
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, 
-            .pNext = &indexingFeatures
+            .pNext = &vulkan12Features
         };
 
         vkGetPhysicalDeviceFeatures2(gpu, &supported);
@@ -232,11 +325,20 @@ Arawn::Engine::Engine()
         if (!supported.features.samplerAnisotropy) 
             throw std::runtime_error("gpu does not support sampler anisotropy feature");
 
-        if (!supported.features.sampleRateShading)
-            throw std::runtime_error("gpu does not support sample rate shading");
+        // optional, without it the visibility render mode is unavailable
+        primitiveIds = supported.features.geometryShader;
 
-        if (!indexingFeatures.descriptorBindingPartiallyBound || !indexingFeatures.runtimeDescriptorArray)
+        if (!vulkan12Features.descriptorBindingPartiallyBound || !vulkan12Features.runtimeDescriptorArray || !vulkan12Features.shaderSampledImageArrayNonUniformIndexing)
             throw std::runtime_error("gpu does not support bindless rendering");
+
+        if (!vulkan12Features.descriptorBindingSampledImageUpdateAfterBind || !vulkan12Features.descriptorBindingUpdateUnusedWhilePending)
+            throw std::runtime_error("gpu does not support updating bindless textures after bind");
+
+        if (!vulkan12Features.timelineSemaphore)
+            throw std::runtime_error("gpu does not support timeline semaphores");
+
+        if (!supported.features.multiDrawIndirect || !supported.features.drawIndirectFirstInstance || !vulkan12Features.drawIndirectCount)
+            throw std::runtime_error("gpu does not support gpu driven rendering");
     }
 
     { // init device
@@ -479,21 +581,29 @@ Arawn::Engine::Engine()
             }
         }
 
-        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{
-            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES, 
+        // vulkan 1.2 features must not be chained alongside their individual feature structs
+        VkPhysicalDeviceVulkan12Features vulkan12Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
             .pNext = nullptr,
+            .drawIndirectCount = VK_TRUE,
+            .shaderSampledImageArrayNonUniformIndexing = VK_TRUE, // per pixel materials of the visibility resolve
+            .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+            .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
             .descriptorBindingPartiallyBound = VK_TRUE,
-            .runtimeDescriptorArray = VK_TRUE
+            .runtimeDescriptorArray = VK_TRUE,
+            .timelineSemaphore = VK_TRUE
         };
 
         VkPhysicalDeviceFeatures coreFeatures{
-            .sampleRateShading = VK_TRUE,
+            .geometryShader = primitiveIds, // gl_PrimitiveID in the visibility buffer
+            .multiDrawIndirect = VK_TRUE,
+            .drawIndirectFirstInstance = VK_TRUE,
             .samplerAnisotropy = VK_TRUE,
         };
 
         VkDeviceCreateInfo info{ 
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO, 
-            .pNext = &indexingFeatures, 
+            .pNext = &vulkan12Features, 
             .flags = 0, 
             .queueCreateInfoCount = static_cast<uint32_t>(queues.size()),
             .pQueueCreateInfos = queues.data(),
@@ -518,6 +628,26 @@ Arawn::Engine::Engine()
             vkGetDeviceQueue(device, family[ASYNC], asyncIndex, &queue[ASYNC]);
             vkGetDeviceQueue(device, family[TRANSFER], transferIndex, &queue[TRANSFER]);
         }
+
+        { // create queue timelines
+            VkSemaphoreTypeCreateInfo typeInfo{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                .pNext = nullptr,
+                .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                .initialValue = 0
+            };
+            VkSemaphoreCreateInfo info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                .pNext = &typeInfo,
+                .flags = 0
+            };
+
+            for (uint32_t i = 0; i < 5; ++i)
+            {
+                VK_ASSERT(vkCreateSemaphore(device, &info, nullptr, &timeline[i]));
+                value[i] = 0;
+            }
+        }
     }
 
     { // init memory allocators
@@ -529,16 +659,87 @@ Arawn::Engine::Engine()
         };
         vmaCreateAllocator(&allocatorInfo, &allocator);
     }
+
+    { // load pipeline cache
+        std::vector<char> data;
+
+        std::ifstream file(PIPELINE_CACHE_PATH, std::ios::binary);
+        PipelineCacheHeader header;
+        if (file.is_open() && file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            PipelineCacheHeader expected = pipelineCacheHeader(gpu, header.size);
+
+            // the stored size must match the rest of the file, a truncated or corrupt one is not allocated
+            std::streamoff start = file.tellg();
+            file.seekg(0, std::ios::end);
+            std::streamoff remaining = file.tellg() - start;
+            file.seekg(start);
+
+            // a cache from another device or driver is discarded rather than handed to the driver
+            if (std::memcmp(&header, &expected, sizeof(header)) == 0 && static_cast<std::streamoff>(header.size) == remaining)
+            {
+                data.resize(header.size);
+                if (!file.read(data.data(), data.size())) data.clear();
+            }
+            else
+            {
+                LOG("pipeline cache invalidated")
+            }
+        }
+
+        VkPipelineCacheCreateInfo info{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .initialDataSize = data.size(),
+            .pInitialData = data.data()
+        };
+
+        // the driver validates the data again, retry empty if it rejects it
+        if (vkCreatePipelineCache(device, &info, nullptr, &pipelineCache) != VK_SUCCESS)
+        {
+            info.initialDataSize = 0;
+            info.pInitialData = nullptr;
+            VK_ASSERT(vkCreatePipelineCache(device, &info, nullptr, &pipelineCache));
+        }
+    }
 }
 
 
 
 Arawn::Engine::~Engine()
 {
-    for (auto& [key, setLayout] : setLayouts) {
+    { // save pipeline cache
+        size_t size;
+        VK_ASSERT(vkGetPipelineCacheData(device, pipelineCache, &size, nullptr));
+
+        std::vector<char> data(size);
+        VK_ASSERT(vkGetPipelineCacheData(device, pipelineCache, &size, data.data()));
+
+        PipelineCacheHeader header = pipelineCacheHeader(gpu, size);
+
+        std::ofstream file(PIPELINE_CACHE_PATH, std::ios::binary | std::ios::trunc);
+        if (file.is_open())
+        {
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(data.data(), size);
+        }
+
+        vkDestroyPipelineCache(device, pipelineCache, nullptr);
+    }
+
+    for (auto& [key, pipelineLayout] : layouts->pipelineLayouts) {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+
+    for (auto& [key, setLayout] : layouts->setLayouts) {
         vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
     }
 
+    for (uint32_t i = 0; i < 5; ++i) {
+        vkDestroySemaphore(device, timeline[i], nullptr);
+    }
+
     vmaDestroyAllocator(allocator);
 
     vkDestroyDevice(device, nullptr);
@@ -548,25 +749,135 @@ Arawn::Engine::~Engine()
     glfwTerminate();
 }
 
-VkDescriptorSetLayout Arawn::Engine::setLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
-    DescriptorLayoutInfo desc{ bindings };
-    auto it = setLayouts.find(desc);
-    if (it == setLayouts.end()) { 
-        return it->second;
+VkDescriptorSetLayout Arawn::Engine::setLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::vector<VkDescriptorBindingFlags>& flags) {
+    DescriptorLayoutInfo desc{ bindings, {}, {} };
+
+    { // normalize key
+        if (std::any_of(flags.begin(), flags.end(), [](VkDescriptorBindingFlags flag) { return flag != 0; })) {
+            std::vector<uint32_t> order(bindings.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) { return bindings[lhs].binding < bindings[rhs].binding; });
+
+            for (uint32_t index : order) {
+                desc.flags.push_back(index < flags.size() ? flags[index] : 0);
+            }
+        }
+
+        std::sort(desc.bindings.begin(), desc.bindings.end(), [](const auto& lhs, const auto& rhs) { return lhs.binding < rhs.binding; });
+
+        for (const VkDescriptorSetLayoutBinding& binding : desc.bindings) {
+            if (binding.pImmutableSamplers != nullptr) {
+                desc.samplers.insert(desc.samplers.end(), binding.pImmutableSamplers, binding.pImmutableSamplers + binding.descriptorCount);
+            }
+        }
     }
-    
-    VkDescriptorSetLayoutCreateInfo info{
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+
+    {
+        std::shared_lock lock(layouts->setMutex);
+        if (auto it = layouts->setLayouts.find(desc); it != layouts->setLayouts.end()) {
+            ++layouts->setHits;
+            return it->second;
+        }
+    }
+
+    VkDescriptorSetLayout setLayout;
+    { // create layout, immutable samplers point into the key's own copy
+        std::vector<VkDescriptorSetLayoutBinding> createBindings = desc.bindings;
+        const VkSampler* samplers = desc.samplers.data();
+        for (VkDescriptorSetLayoutBinding& binding : createBindings) {
+            if (binding.pImmutableSamplers != nullptr) {
+                binding.pImmutableSamplers = samplers;
+                samplers += binding.descriptorCount;
+            }
+        }
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            .pNext = nullptr,
+            .bindingCount = static_cast<uint32_t>(desc.flags.size()),
+            .pBindingFlags = desc.flags.data()
+        };
+
+        // update after bind bindings can only be allocated from pools created for them
+        bool updateAfterBind = std::any_of(desc.flags.begin(), desc.flags.end(), [](VkDescriptorBindingFlags flag) { return flag & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT; });
+
+        VkDescriptorSetLayoutCreateInfo info{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext = desc.flags.empty() ? nullptr : &flagsInfo,
+            .flags = updateAfterBind ? static_cast<VkDescriptorSetLayoutCreateFlags>(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT) : 0u,
+            .bindingCount = static_cast<uint32_t>(createBindings.size()),
+            .pBindings = createBindings.data(),
+        };
+
+        VK_ASSERT(vkCreateDescriptorSetLayout(device, &info, nullptr, &setLayout));
+    }
+
+    std::unique_lock lock(layouts->setMutex);
+    auto [it, inserted] = layouts->setLayouts.try_emplace(std::move(desc), setLayout);
+    if (!inserted) {
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+        ++layouts->setHits;
+    } else {
+        ++layouts->setMisses;
+    }
+
+    return it->second;
+}
+
+VkPipelineLayout Arawn::Engine::pipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& ranges) {
+    PipelineLayoutInfo desc{ setLayouts, ranges };
+
+    {
+        std::shared_lock lock(layouts->pipelineMutex);
+        if (auto it = layouts->pipelineLayouts.find(desc); it != layouts->pipelineLayouts.end()) {
+            ++layouts->pipelineHits;
+            return it->second;
+        }
+    }
+
+    VkPipelineLayoutCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .bindingCount = static_cast<uint32_t>(desc.bindings.size()),
-        .pBindings = desc.bindings.data(),
+        .setLayoutCount = static_cast<uint32_t>(desc.setLayouts.size()),
+        .pSetLayouts = desc.setLayouts.data(),
+        .pushConstantRangeCount = static_cast<uint32_t>(desc.ranges.size()),
+        .pPushConstantRanges = desc.ranges.data()
     };
-    
-    VkDescriptorSetLayout setLayout;
-    vkCreateDescriptorSetLayout(device, &info, nullptr, &setLayout);
 
-    it = setLayouts.emplace_hint(it, std::move(desc), setLayout);
+    VkPipelineLayout layout;
+    VK_ASSERT(vkCreatePipelineLayout(device, &info, nullptr, &layout));
+
+    std::unique_lock lock(layouts->pipelineMutex);
+    auto [it, inserted] = layouts->pipelineLayouts.try_emplace(std::move(desc), layout);
+    if (!inserted) {
+        vkDestroyPipelineLayout(device, layout, nullptr);
+        ++layouts->pipelineHits;
+    } else {
+        ++layouts->pipelineMisses;
+    }
+
+    return it->second;
+}
 
-    return setLayout;
-}
\ No newline at end of file
+Arawn::Engine::LayoutStatistics Arawn::Engine::layoutStatistics() const {
+    return { layouts->setHits, layouts->setMisses, layouts->pipelineHits, layouts->pipelineMisses };
+}
+
+uint64_t Arawn::Engine::completed(QueueType type) const {
+    uint64_t current;
+    VK_ASSERT(vkGetSemaphoreCounterValue(device, timeline[type], &current));
+    return current;
+}
+
+void Arawn::Engine::wait(QueueType type, uint64_t value) const {
+    VkSemaphoreWaitInfo info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .semaphoreCount = 1,
+        .pSemaphores = &timeline[type],
+        .pValues = &value
+    };
+    VK_ASSERT(vkWaitSemaphores(device, &info, UINT64_MAX));
+}
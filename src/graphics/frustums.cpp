@@ -0,0 +1,99 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/frustums.h>
+#include <algorithm>
+
+using namespace Arawn;
+
+constexpr uint32_t frustumWorkgroupSize = 8; // WORKGROUP_SIZE in cull/frustum.comp
+
+static_assert(sizeof(Frustum) == 64, "frustum must match the std430 shader layout");
+
+FrustumGrid::FrustumGrid(uint32_t frameCount)
+ : projection{}, width(0), height(0), tileSize(0), x(0), y(0), generation(0), grids(frameCount)
+{ }
+
+bool FrustumGrid::update(const Render::Task::Context& context, const Program& program, const float proj[16], uint32_t width, uint32_t height, uint32_t tileSize) {
+    { // a changed projection, screen or tile size makes every frame's grid stale
+        bool changed = width != this->width || height != this->height || tileSize != this->tileSize || !std::equal(proj, proj + 16, projection);
+        if (changed) {
+            std::copy(proj, proj + 16, projection);
+            this->width = width;
+            this->height = height;
+            this->tileSize = tileSize;
+            x = (width + tileSize - 1) / tileSize;
+            y = (height + tileSize - 1) / tileSize;
+            ++generation;
+        }
+    }
+
+    Grid& grid = grids[context.frameIndex];
+    if (grid.generation == generation) return false;
+
+    // the frame's previous submit has finished, so its buffer may be replaced
+    if (grid.capacity < x * y) {
+        grid.frustums = std::make_unique<Buffer>(x * y * sizeof(Frustum), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+        grid.capacity = x * y;
+    }
+
+    { // bind the frame's grid
+        VkDescriptorSet descriptorSet = context.descriptor(program, 1);
+
+        VkDescriptorBufferInfo info { grid.frustums->buffer, 0, x * y * sizeof(Frustum) };
+
+        VkWriteDescriptorSet write {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &info
+        };
+
+        vkUpdateDescriptorSets(engine.device, 1, &write, 0, nullptr);
+        vkCmdBindDescriptorSets(context.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program.layout, 1, 1, &descriptorSet, 0, nullptr);
+    }
+
+    uint32_t constants[3] { x, y, tileSize };
+
+    vkCmdBindPipeline(context.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program.pipeline);
+    vkCmdPushConstants(context.cmd, program.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), constants);
+    vkCmdDispatch(context.cmd, (x + frustumWorkgroupSize - 1) / frustumWorkgroupSize, (y + frustumWorkgroupSize - 1) / frustumWorkgroupSize, 1);
+
+    { // grid written before light culling reads it
+        VkBufferMemoryBarrier barrier {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = grid.frustums->buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        };
+
+        vkCmdPipelineBarrier(context.cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    grid.generation = generation;
+    return true;
+}
+
+uint32_t FrustumGrid::tilesX() const {
+    return x;
+}
+
+uint32_t FrustumGrid::tilesY() const {
+    return y;
+}
+
+VkBuffer FrustumGrid::buffer(const Render::Task::Context& context) const {
+    const Grid& grid = grids[context.frameIndex];
+
+    // unallocated before the first update, stale until the frame's update after a change
+    if (grid.frustums == nullptr || grid.generation != generation) {
+        throw std::runtime_error("frustum grid read before the frame's update");
+    }
+
+    return grid.frustums->buffer;
+}
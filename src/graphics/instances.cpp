@@ -0,0 +1,215 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/instances.h>
+#include <algorithm>
+
+using namespace Arawn;
+
+constexpr uint32_t cullWorkgroupSize = 64;      // WORKGROUP_SIZE in cull/instance.comp
+constexpr uint32_t maxWorkgroupCount = 65535;    // minimum maxComputeWorkGroupCount, meshlet culling dispatches a work group per instance
+
+static_assert(sizeof(Instance) == 96, "instance must match the std430 shader layout");
+static_assert(sizeof(Mesh) == 20, "mesh must match the std430 shader layout");
+static_assert(sizeof(Meshlet) == 48, "meshlet must match the std430 shader layout");
+
+Instances::Instances(StagingRing& staging, uint32_t capacity, uint32_t meshCapacity, uint32_t meshletCapacity, uint32_t drawCapacity)
+ : staging(staging), capacity(capacity), instanceCount(0), meshCapacity(meshCapacity), meshCount(0),
+   meshletCapacity(meshletCapacity), meshletCount(0), drawCapacity(drawCapacity),
+   instances(capacity * sizeof(Instance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY),
+   meshes(meshCapacity * sizeof(Mesh), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY),
+   meshlets(meshletCapacity * sizeof(Meshlet), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY)
+{ }
+
+uint32_t Instances::mesh(const Mesh& mesh) {
+    return this->mesh(mesh, {});
+}
+
+uint32_t Instances::mesh(const Mesh& mesh, const std::vector<Meshlet>& data) {
+    if (meshCount == meshCapacity) throw std::runtime_error("mesh buffer is full");
+    if (meshletCount + data.size() > meshletCapacity) throw std::runtime_error("meshlet buffer is full");
+
+    Mesh entry = mesh;
+    entry.meshletOffset = meshletCount;
+    entry.meshletCount = static_cast<uint32_t>(data.size());
+
+    if (!data.empty()) {
+        staging.upload(meshlets, data.data(), data.size() * sizeof(Meshlet), meshletCount * sizeof(Meshlet));
+        meshletCount += entry.meshletCount;
+    }
+
+    staging.upload(meshes, &entry, sizeof(Mesh), meshCount * sizeof(Mesh));
+    return meshCount++;
+}
+
+uint32_t Instances::add(const Instance& instance) {
+    if (instanceCount == capacity) throw std::runtime_error("instance buffer is full");
+
+    update(instanceCount, instance);
+    return instanceCount++;
+}
+
+void Instances::update(uint32_t instance, const Instance& data) {
+    // instances already added may be read by frames in flight, overwriting one waits for those frames to finish
+    staging.upload(instances, &data, sizeof(Instance), instance * sizeof(Instance), GRAPHICS, instance < instanceCount);
+}
+
+uint32_t Instances::count() const {
+    return instanceCount;
+}
+
+uint64_t Instances::commandSize() const {
+    return capacity * sizeof(VkDrawIndexedIndirectCommand);
+}
+
+uint64_t Instances::meshletCommandSize() const {
+    return drawCapacity * sizeof(VkDrawIndexedIndirectCommand);
+}
+
+void Instances::cull(const Render::Task::Context& context, const Program& program, VkBuffer commands, VkBuffer count) const {
+    record(context, program, commands, count, nullptr, false);
+}
+
+void Instances::cull(const Render::Task::Context& context, const Program& program, VkBuffer commands, VkBuffer count, const DepthPyramid& pyramid, VkImageView view) const {
+    VkDescriptorImageInfo info { pyramid.sampler, view, VK_IMAGE_LAYOUT_GENERAL };
+    record(context, program, commands, count, &info, false);
+}
+
+void Instances::cullMeshlets(const Render::Task::Context& context, const Program& program, VkBuffer commands, VkBuffer count) const {
+    record(context, program, commands, count, nullptr, true);
+}
+
+void Instances::record(const Render::Task::Context& context, const Program& program, VkBuffer commands, VkBuffer count, const VkDescriptorImageInfo* pyramid, bool perMeshlet) const {
+    { // reset draw count
+        vkCmdFillBuffer(context.cmd, count, 0, countSize, 0);
+
+        VkBufferMemoryBarrier barrier {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = count,
+            .offset = 0,
+            .size = countSize
+        };
+
+        vkCmdPipelineBarrier(context.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    if (instanceCount == 0) return;
+
+    { // bind culling inputs and outputs
+        VkDescriptorSet descriptorSet = context.descriptor(program, 1);
+
+        VkDescriptorBufferInfo infos[4] {
+            { instances.buffer, 0, instanceCount * sizeof(Instance) },
+            { meshes.buffer, 0, VK_WHOLE_SIZE },
+            { commands, 0, VK_WHOLE_SIZE },
+            { count, 0, countSize }
+        };
+
+        VkDescriptorBufferInfo meshletInfo { meshlets.buffer, 0, VK_WHOLE_SIZE };
+
+        std::vector<VkWriteDescriptorSet> writes;
+        writes.push_back({
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 4,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = infos
+        });
+
+        if (pyramid != nullptr) {
+            writes.push_back({
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSet,
+                .dstBinding = 4,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = pyramid
+            });
+        }
+
+        if (perMeshlet) {
+            writes.push_back({
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSet,
+                .dstBinding = 4,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &meshletInfo
+            });
+        }
+
+        vkUpdateDescriptorSets(engine.device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        vkCmdBindPipeline(context.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program.pipeline);
+        vkCmdBindDescriptorSets(context.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program.layout, 1, 1, &descriptorSet, 0, nullptr);
+    }
+
+    if (perMeshlet) {
+        uint32_t constants[2] = { instanceCount, drawCapacity };
+        vkCmdPushConstants(context.cmd, program.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), constants);
+        vkCmdDispatch(context.cmd, std::min(instanceCount, maxWorkgroupCount), (instanceCount + maxWorkgroupCount - 1) / maxWorkgroupCount, 1);
+    } else {
+        vkCmdPushConstants(context.cmd, program.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &instanceCount);
+        vkCmdDispatch(context.cmd, (instanceCount + cullWorkgroupSize - 1) / cullWorkgroupSize, 1, 1);
+    }
+}
+
+void Instances::bind(const Render::Task::Context& context, const Program& program) const {
+    VkDescriptorSet descriptorSet = context.descriptor(program, 1);
+
+    VkDescriptorBufferInfo info { instances.buffer, 0, VK_WHOLE_SIZE };
+
+    VkWriteDescriptorSet write {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = descriptorSet,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &info
+    };
+
+    vkUpdateDescriptorSets(engine.device, 1, &write, 0, nullptr);
+    vkCmdBindDescriptorSets(context.cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, program.layout, 1, 1, &descriptorSet, 0, nullptr);
+}
+
+void Instances::bindGeometry(const Render::Task::Context& context, const Program& program, VkBuffer vertices, VkBuffer indices) const {
+    VkDescriptorSet descriptorSet = context.descriptor(program, 4);
+
+    VkDescriptorBufferInfo infos[] = {
+        { instances.buffer, 0, VK_WHOLE_SIZE },
+        { meshes.buffer, 0, VK_WHOLE_SIZE },
+        { vertices, 0, VK_WHOLE_SIZE },
+        { indices, 0, VK_WHOLE_SIZE }
+    };
+
+    VkWriteDescriptorSet writes[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+        writes[i] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = i,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &infos[i]
+        };
+    }
+
+    vkUpdateDescriptorSets(engine.device, 4, writes, 0, nullptr);
+    vkCmdBindDescriptorSets(context.cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, program.layout, 4, 1, &descriptorSet, 0, nullptr);
+}
+
+void Instances::draw(VkCommandBuffer cmd, VkBuffer commands, VkBuffer count) const {
+    vkCmdDrawIndexedIndirectCount(cmd, commands, 0, count, 0, capacity, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void Instances::drawMeshlets(VkCommandBuffer cmd, VkBuffer commands, VkBuffer count) const {
+    vkCmdDrawIndexedIndirectCount(cmd, commands, 0, count, 0, drawCapacity, sizeof(VkDrawIndexedIndirectCommand));
+}
@@ -0,0 +1,129 @@
+#include <graphics/meshlet.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Arawn;
+
+namespace {
+struct Vec3 { float x, y, z; };
+
+Vec3 operator+(Vec3 lhs, Vec3 rhs) { return { lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z }; }
+Vec3 operator-(Vec3 lhs, Vec3 rhs) { return { lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z }; }
+Vec3 operator*(Vec3 lhs, float rhs) { return { lhs.x * rhs, lhs.y * rhs, lhs.z * rhs }; }
+float dot(Vec3 lhs, Vec3 rhs) { return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z; }
+Vec3 cross(Vec3 lhs, Vec3 rhs) { return { lhs.y * rhs.z - lhs.z * rhs.y, lhs.z * rhs.x - lhs.x * rhs.z, lhs.x * rhs.y - lhs.y * rhs.x }; }
+
+Vec3 position(const void* positions, uint32_t stride, uint32_t vertex) {
+    Vec3 result;
+    std::memcpy(&result, static_cast<const uint8_t*>(positions) + static_cast<std::size_t>(vertex) * stride, sizeof(Vec3));
+    return result;
+}
+
+// bounding sphere of the meshlet's unique vertices and the cone bounding its triangle normals
+Meshlet bounds(const uint32_t* indices, uint32_t indexCount, const std::vector<uint32_t>& vertices, const void* positions, uint32_t stride) {
+    Meshlet meshlet{};
+
+    { // sphere around the centroid
+        Vec3 centre{ 0, 0, 0 };
+        for (uint32_t vertex : vertices) {
+            centre = centre + position(positions, stride, vertex);
+        }
+        centre = centre * (1.0f / vertices.size());
+
+        float radius = 0;
+        for (uint32_t vertex : vertices) {
+            Vec3 d = position(positions, stride, vertex) - centre;
+            radius = std::max(radius, dot(d, d));
+        }
+
+        meshlet.sphere[0] = centre.x;
+        meshlet.sphere[1] = centre.y;
+        meshlet.sphere[2] = centre.z;
+        meshlet.sphere[3] = std::sqrt(radius);
+    }
+
+    { // normal cone, a cutoff of 1 never culls
+        std::vector<Vec3> normals;
+        Vec3 axis{ 0, 0, 0 };
+        for (uint32_t i = 0; i < indexCount; i += 3) {
+            Vec3 a = position(positions, stride, indices[i + 0]);
+            Vec3 b = position(positions, stride, indices[i + 1]);
+            Vec3 c = position(positions, stride, indices[i + 2]);
+
+            Vec3 normal = cross(b - a, c - a);
+            float length = std::sqrt(dot(normal, normal));
+            if (length == 0) continue; // degenerate
+
+            normals.push_back(normal * (1.0f / length));
+            axis = axis + normals.back();
+        }
+
+        float length = std::sqrt(dot(axis, axis));
+        float cutoff = 1;
+        if (length > 0) {
+            axis = axis * (1.0f / length);
+
+            float minimum = 1;
+            for (Vec3 normal : normals) {
+                minimum = std::min(minimum, dot(axis, normal));
+            }
+
+            // back facing when the view direction is within 90 degrees minus the normals' spread of the axis
+            cutoff = minimum <= 0 ? 1 : std::sqrt(1 - minimum * minimum);
+        }
+
+        meshlet.cone[0] = axis.x;
+        meshlet.cone[1] = axis.y;
+        meshlet.cone[2] = axis.z;
+        meshlet.cone[3] = cutoff;
+    }
+
+    return meshlet;
+}
+}
+
+Meshlets Arawn::buildMeshlets(const uint32_t* indices, uint32_t indexCount, const void* positions, uint32_t vertexCount, uint32_t stride, uint32_t maxVertices, uint32_t maxTriangles) {
+    Meshlets result;
+    result.indices.reserve(indexCount);
+
+    std::vector<uint32_t> owner(vertexCount, UINT32_MAX); // last meshlet to reference the vertex
+    std::vector<uint32_t> vertices;
+    uint32_t firstIndex = 0;
+
+    auto finish = [&]() {
+        uint32_t count = static_cast<uint32_t>(result.indices.size()) - firstIndex;
+        if (count == 0) return;
+
+        Meshlet& meshlet = result.meshlets.emplace_back(bounds(result.indices.data() + firstIndex, count, vertices, positions, stride));
+        meshlet.firstIndex = firstIndex;
+        meshlet.indexCount = count;
+
+        firstIndex = static_cast<uint32_t>(result.indices.size());
+        vertices.clear();
+    };
+
+    for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+        uint32_t meshletIndex = static_cast<uint32_t>(result.meshlets.size());
+        uint32_t added = (owner[indices[i]] != meshletIndex) + (owner[indices[i + 1]] != meshletIndex) + (owner[indices[i + 2]] != meshletIndex);
+        uint32_t triangles = (static_cast<uint32_t>(result.indices.size()) - firstIndex) / 3;
+
+        if (vertices.size() + added > maxVertices || triangles + 1 > maxTriangles) {
+            finish();
+            meshletIndex = static_cast<uint32_t>(result.meshlets.size());
+        }
+
+        for (uint32_t j = 0; j < 3; ++j) {
+            uint32_t vertex = indices[i + j];
+            if (owner[vertex] != meshletIndex) {
+                owner[vertex] = meshletIndex;
+                vertices.push_back(vertex);
+            }
+            result.indices.push_back(vertex);
+        }
+    }
+
+    finish();
+
+    return result;
+}
@@ -0,0 +1,194 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/pipelines.h>
+#include <core/settings.h>
+#include <algorithm>
+
+using namespace Arawn;
+
+// spir-v of a source in res/shader, multisampled sources are compiled a second time with MULTISAMPLED defined
+static std::string shader(std::string_view source, bool multisampled = false) {
+    return multisampled ? Program::permutation(source, { "MULTISAMPLED" }) : Program::permutation(source);
+}
+
+Pipelines::Pipelines(VkFormat colour)
+ : permutations(enumerate(colour)), finished(0)
+{
+    programs.resize(permutations.size());
+    done = std::make_unique<std::atomic<bool>[]>(permutations.size());
+
+    thread = std::thread([this]() {
+        workers.dispatch(static_cast<uint32_t>(permutations.size()), [this](uint32_t thread, uint32_t index) {
+            try
+            {
+                programs[index].reset(compile(permutations[index]));
+            }
+            catch (const std::exception& e)
+            {
+                // any escaping exception would leave done unset and block get forever
+                LOG("failed to precompile " << permutations[index].vertex << permutations[index].compute << " " << permutations[index].fragment << ": " << e.what())
+            }
+
+            done[index] = true;
+            done[index].notify_all();
+            ++finished;
+        });
+
+        LOG("precompiled " << finished << " pipelines")
+    });
+}
+
+Pipelines::~Pipelines() {
+    thread.join();
+}
+
+bool Pipelines::ready() const {
+    return finished == permutations.size();
+}
+
+uint32_t Pipelines::compiled() const {
+    return finished;
+}
+
+uint32_t Pipelines::count() const {
+    return static_cast<uint32_t>(permutations.size());
+}
+
+const Program& Pipelines::get(const Permutation& permutation) {
+    auto it = std::find(permutations.begin(), permutations.end(), permutation);
+
+    if (it != permutations.end()) {
+        uint32_t index = static_cast<uint32_t>(it - permutations.begin());
+        done[index].wait(false);
+
+        if (!programs[index]) throw std::runtime_error("pipeline failed to compile");
+        return *programs[index];
+    }
+
+    std::lock_guard lock(mutex);
+
+    auto extraIt = std::find_if(extra.begin(), extra.end(), [&](const auto& entry) { return entry.first == permutation; });
+    if (extraIt != extra.end()) {
+        return *extraIt->second;
+    }
+
+    return *extra.emplace_back(permutation, std::unique_ptr<Program>(compile(permutation))).second;
+}
+
+Program* Pipelines::compile(const Permutation& permutation) {
+    if (!permutation.compute.empty()) {
+        return new Program(permutation.compute.c_str());
+    }
+
+    return new Program(permutation.vertex.c_str(), permutation.fragment.c_str(), permutation.target);
+}
+
+std::vector<Pipelines::Permutation> Pipelines::enumerate(VkFormat colour) {
+    std::vector<Permutation> permutations;
+
+    auto add = [&](Permutation permutation) {
+        if (std::find(permutations.begin(), permutations.end(), permutation) == permutations.end()) {
+            permutations.push_back(std::move(permutation));
+        }
+    };
+
+    // albedo, octahedral normal, metallic + roughness. position is reconstructed from depth
+    const std::vector<VkFormat> gbuffer = { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R8G8_UNORM };
+    const VkFormat visibility = VK_FORMAT_R32G32_UINT; // instance + triangle
+    const VkFormat depth = VK_FORMAT_D32_SFLOAT;
+
+    // gpu driven instance culling, shared by every mode
+    add({ shader("cull/instance.comp"), "", "", {} });
+    add({ shader("cull/meshlet.comp"), "", "", {} });
+
+    for (AntiAlias::Enum antiAlias : { AntiAlias::DISABLED, AntiAlias::MSAA_2, AntiAlias::MSAA_4, AntiAlias::MSAA_8 }) {
+        uint32_t samples = 1u << (antiAlias >> 4);
+        bool multisampled = samples > 1;
+
+        for (DepthMode::Enum depthMode : { DepthMode::DISABLED, DepthMode::ENABLED }) {
+            bool prepass = depthMode == DepthMode::ENABLED;
+
+            if (prepass) {
+                add({ "", shader("transform/basic.vert"), shader("empty.frag"), { {}, depth, samples, false, true } });
+
+                // occlusion culling against the prepass depth pyramid
+                add({ shader("cull/hiz.comp", multisampled), "", "", {} });
+                add({ shader("cull/hiz.comp"), "", "", {} });
+                add({ shader("cull/occlusion.comp"), "", "", {} });
+            }
+
+            for (CullingMode::Enum cullingMode : { CullingMode::DISABLED, CullingMode::TILE, CullingMode::TILE_25D, CullingMode::CLUSTER, CullingMode::ZBIN }) {
+                { // light culling
+                    switch (cullingMode) {
+                        case CullingMode::TILE:
+                            add({ shader("cull/frustum.comp"), "", "", {} });
+                            add({ shader("cull/tiled.comp", multisampled), "", "", {} });
+                            break;
+                        case CullingMode::TILE_25D:
+                            add({ shader("cull/frustum.comp"), "", "", {} });
+                            add({ shader("cull/tiled25d.comp", multisampled), "", "", {} });
+                            break;
+                        case CullingMode::CLUSTER:
+                            add({ shader("cull/frustum.comp"), "", "", {} });
+                            add({ shader("cull/bin.comp"), "", "", {} });
+                            add({ shader("cull/clustered.comp"), "", "", {} });
+                            break;
+                        case CullingMode::ZBIN:
+                            add({ shader("cull/frustum.comp"), "", "", {} });
+                            add({ shader("cull/zsort.comp"), "", "", {} });
+                            add({ shader("cull/zbin.comp"), "", "", {} });
+                            add({ shader("cull/zmask.comp"), "", "", {} });
+                            break;
+                        default:
+                            break;
+                    }
+                }
+
+                for (RenderMode::Enum renderMode : { RenderMode::FORWARD, RenderMode::DEFERRED, RenderMode::VISIBILITY }) {
+                    if (renderMode == RenderMode::FORWARD) {
+                        std::string_view fragment;
+                        switch (cullingMode) {
+                            case CullingMode::TILE:
+                            case CullingMode::TILE_25D: fragment = "forward/tiled.frag"; break;
+                            case CullingMode::CLUSTER:  fragment = "forward/clustered.frag"; break;
+                            case CullingMode::ZBIN:     fragment = "forward/zbinned.frag"; break;
+                            default:                    fragment = "forward/standard.frag"; break;
+                        }
+
+                        add({ "", shader("transform/tbn.vert"), shader(fragment), { { colour }, depth, samples, multisampled, !prepass } });
+                    } else if (renderMode == RenderMode::VISIBILITY) {
+                        // ids can not be resolved per sample, the visibility buffer is single sampled
+                        if (multisampled || !engine.primitiveIds) continue;
+
+                        std::string_view fragment;
+                        switch (cullingMode) {
+                            case CullingMode::TILE:
+                            case CullingMode::TILE_25D: fragment = "visibility/tiled.frag"; break;
+                            case CullingMode::CLUSTER:  fragment = "visibility/clustered.frag"; break;
+                            case CullingMode::ZBIN:     fragment = "visibility/zbinned.frag"; break;
+                            default:                    fragment = "visibility/present.frag"; break;
+                        }
+
+                        add({ "", shader("transform/visibility.vert"), shader("visibility/visibility.frag"), { { visibility }, depth, samples, false, !prepass } });
+                        add({ "", shader("transform/fullscreen.vert"), shader(fragment), { { colour }, VK_FORMAT_UNDEFINED, 1, false, false } });
+                    } else {
+                        std::string_view fragment;
+                        switch (cullingMode) {
+                            case CullingMode::TILE:
+                            case CullingMode::TILE_25D: fragment = "deferred/tiled.frag"; break;
+                            case CullingMode::CLUSTER:  fragment = "deferred/clustered.frag"; break;
+                            case CullingMode::ZBIN:     fragment = "deferred/zbinned.frag"; break;
+                            default:                    fragment = "deferred/present.frag"; break;
+                        }
+
+                        // g-buffer and lighting are subpasses of one render pass, the g-buffer never leaves tile memory.
+                        // multisampled lighting runs once per pixel, the g-buffer sample count is pushed and only edge pixels loop over it
+                        add({ "", shader("transform/tbn.vert"), shader("deferred/geometry.frag"), { gbuffer, depth, samples, false, !prepass, colour, 0 } });
+                        add({ "", shader("transform/fullscreen.vert"), shader(fragment, multisampled), { gbuffer, depth, samples, false, !prepass, colour, 1 } });
+                    }
+                }
+            }
+        }
+    }
+
+    return permutations;
+}
@@ -0,0 +1,103 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/pyramid.h>
+#include <algorithm>
+#include <bit>
+
+using namespace Arawn;
+
+constexpr uint32_t reduceWorkgroupSize = 8; // local size of cull/hiz.comp
+
+DepthPyramid::DepthPyramid(uint32_t width, uint32_t height)
+ : x(std::max((width + 1) / 2, 1u)), y(std::max((height + 1) / 2, 1u))
+{
+    levelCount = std::bit_width(std::max(x, y));
+
+    VkSamplerCreateInfo info {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .maxLod = VK_LOD_CLAMP_NONE
+    };
+
+    VK_ASSERT(vkCreateSampler(engine.device, &info, nullptr, &sampler));
+}
+
+DepthPyramid::~DepthPyramid() {
+    vkDestroySampler(engine.device, sampler, nullptr);
+}
+
+uint32_t DepthPyramid::width() const {
+    return x;
+}
+
+uint32_t DepthPyramid::height() const {
+    return y;
+}
+
+uint32_t DepthPyramid::levels() const {
+    return levelCount;
+}
+
+void DepthPyramid::build(const Render::Task::Context& context, const Program& first, const Program& rest, VkImageView depth, uint32_t pyramid) const {
+    VkImage image = context.graph.image(pyramid, context.frameIndex);
+
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const Program& program = level == 0 ? first : rest;
+
+        if (level > 0) { // previous level written before it is read
+            VkImageMemoryBarrier barrier {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+                .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = image,
+                .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, 1 }
+            };
+
+            vkCmdPipelineBarrier(context.cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        }
+
+        VkDescriptorSet descriptorSet = context.descriptor(program, 0);
+
+        { // bind source and destination level
+            VkImageView srcView = level == 0 ? depth : context.graph.view(pyramid, context.frameIndex, level - 1);
+            VkDescriptorImageInfo src { sampler, srcView, level == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL };
+            VkDescriptorImageInfo dst { VK_NULL_HANDLE, context.graph.view(pyramid, context.frameIndex, level), VK_IMAGE_LAYOUT_GENERAL };
+
+            VkWriteDescriptorSet writes[2] {
+                {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSet,
+                    .dstBinding = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    .pImageInfo = &src
+                },
+                {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSet,
+                    .dstBinding = 1,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                    .pImageInfo = &dst
+                }
+            };
+
+            vkUpdateDescriptorSets(engine.device, 2, writes, 0, nullptr);
+        }
+
+        uint32_t levelX = std::max(x >> level, 1u);
+        uint32_t levelY = std::max(y >> level, 1u);
+
+        vkCmdBindPipeline(context.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program.pipeline);
+        vkCmdBindDescriptorSets(context.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program.layout, 0, 1, &descriptorSet, 0, nullptr);
+        vkCmdDispatch(context.cmd, (levelX + reduceWorkgroupSize - 1) / reduceWorkgroupSize, (levelY + reduceWorkgroupSize - 1) / reduceWorkgroupSize, 1);
+    }
+}
@@ -0,0 +1,1147 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/renderer.h>
+#include <graphics/engine.h>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <bit>
+
+using namespace Arawn;
+
+constexpr VkAccessFlags writeAccessMask =
+    VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+static VkImageAspectFlags aspectMask(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+
+
+Render::Task::Task(QueueType queue, Callback callback, std::pmr::memory_resource* cache)
+ : queue(queue), callback(std::move(callback)), images(cache), buffers(cache) { }
+
+Render::Task& Render::Task::use(uint32_t resource, Image::Usage usage) {
+    images.emplace_back(resource, usage);
+    return *this;
+}
+
+Render::Task& Render::Task::use(uint32_t resource, Buffer::Usage usage) {
+    buffers.emplace_back(resource, usage);
+    return *this;
+}
+
+
+
+uint32_t Render::Builder::image(VkFormat format, uint32_t x, uint32_t y, VkImageUsageFlags usage, uint32_t samples, uint32_t levels) {
+    Resource::Type type = (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) ? Resource::ATTACHMENT : Resource::IMAGE;
+    resources.push_back({ .type = type, .levels = levels, .samples = samples, .x = x, .y = y, .z = 1, .format = format, .usage = usage, .size = 0 });
+    return static_cast<uint32_t>(resources.size() - 1);
+}
+
+uint32_t Render::Builder::buffer(uint64_t size, VkBufferUsageFlags usage) {
+    resources.push_back({ .type = Resource::BUFFER, .levels = 0, .samples = 0, .x = 0, .y = 0, .z = 0, .format = VK_FORMAT_UNDEFINED, .usage = usage, .size = size });
+    return static_cast<uint32_t>(resources.size() - 1);
+}
+
+uint32_t Render::Builder::swapchain() {
+    resources.push_back({ .type = Resource::SWAPCHAIN, .levels = 1, .samples = 1, .x = 0, .y = 0, .z = 1, .format = VK_FORMAT_UNDEFINED, .usage = 0, .size = 0 });
+    return static_cast<uint32_t>(resources.size() - 1);
+}
+
+Render::Task& Render::Builder::task(QueueType queue, Task::Callback callback) {
+    return tasks.emplace_back(queue, std::move(callback), &cache);
+}
+
+
+
+Render::Graph::Graph(Builder& builder, Swapchain& swapchain, uint32_t frameCount)
+ : swapchain(swapchain), frameCount(frameCount), frameIndex(0), imageCount(0), imageIndex(0), descriptors(frameCount, workers.size())
+{
+    compile(builder);
+    allocate();
+
+    { // create command pools
+        for (uint32_t queue = 0; queue < 5; ++queue) {
+            pools[queue] = VK_NULL_HANDLE;
+        }
+
+        for (Batch& batch : batches) {
+            if (pools[batch.queue] != VK_NULL_HANDLE) continue;
+
+            VkCommandPoolCreateInfo info{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                .queueFamilyIndex = engine.family[batch.queue]
+            };
+            VK_ASSERT(vkCreateCommandPool(engine.device, &info, nullptr, &pools[batch.queue]));
+        }
+    }
+
+    { // allocate command buffers
+        commands.resize(frameCount * batches.size());
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            for (uint32_t i = 0; i < batches.size(); ++i) {
+                VkCommandBufferAllocateInfo info{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .pNext = nullptr,
+                    .commandPool = pools[batches[i].queue],
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 1
+                };
+                VK_ASSERT(vkAllocateCommandBuffers(engine.device, &info, &commands[frame * batches.size() + i]));
+            }
+        }
+    }
+
+    { // create per thread command pools for secondary command buffers
+        recorders.resize(frameCount * workers.size());
+        for (Recorder& recorder : recorders) {
+            for (uint32_t queue = 0; queue < 5; ++queue) {
+                recorder.pools[queue] = VK_NULL_HANDLE;
+                recorder.used[queue] = 0;
+                if (pools[queue] == VK_NULL_HANDLE) continue;
+
+                VkCommandPoolCreateInfo info{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                    .pNext = nullptr,
+                    .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                    .queueFamilyIndex = engine.family[queue]
+                };
+                VK_ASSERT(vkCreateCommandPool(engine.device, &info, nullptr, &recorder.pools[queue]));
+            }
+        }
+    }
+
+    { // create sync objects
+        // cross queue and frame pacing dependencies use the engine's queue timelines,
+        // binary semaphores are only required by acquire and present
+        VkSemaphoreCreateInfo semaphoreInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0
+        };
+
+        values.assign(frameCount * batches.size(), 0);
+
+        imageReady.resize(frameCount);
+        frameReady.resize(frameCount);
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            VK_ASSERT(vkCreateSemaphore(engine.device, &semaphoreInfo, nullptr, &imageReady[frame]));
+            VK_ASSERT(vkCreateSemaphore(engine.device, &semaphoreInfo, nullptr, &frameReady[frame]));
+        }
+    }
+}
+
+Render::Graph::~Graph() {
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        wait(frame, UINT64_MAX);
+    }
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        vkDestroySemaphore(engine.device, imageReady[frame], nullptr);
+        vkDestroySemaphore(engine.device, frameReady[frame], nullptr);
+    }
+
+    for (uint32_t queue = 0; queue < 5; ++queue) {
+        if (pools[queue] != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(engine.device, pools[queue], nullptr);
+        }
+
+        for (Recorder& recorder : recorders) {
+            if (recorder.pools[queue] != VK_NULL_HANDLE) {
+                vkDestroyCommandPool(engine.device, recorder.pools[queue], nullptr);
+            }
+        }
+    }
+
+    for (VkImageView view : imageViews) {
+        vkDestroyImageView(engine.device, view, nullptr);
+    }
+
+    for (VkImageView view : levelViews) {
+        vkDestroyImageView(engine.device, view, nullptr);
+    }
+
+    for (Handle& handle : handles) {
+        if (handle.view != VK_NULL_HANDLE) {
+            vkDestroyImageView(engine.device, handle.view, nullptr);
+        }
+
+        if (handle.image != VK_NULL_HANDLE) {
+            vkDestroyImage(engine.device, handle.image, nullptr);
+        }
+
+        if (handle.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(engine.device, handle.buffer, nullptr);
+        }
+
+        if (handle.allocation != VK_NULL_HANDLE) {
+            vmaFreeMemory(engine.allocator, handle.allocation);
+        }
+    }
+
+    for (VmaAllocation heap : heaps) {
+        vmaFreeMemory(engine.allocator, heap);
+    }
+}
+
+void Render::Graph::compile(Builder& builder) {
+    resources.assign(builder.resources.begin(), builder.resources.end());
+    lifetimes.assign(resources.size(), Lifetime{ UINT32_MAX, UINT32_MAX, 0, 0, 0 });
+
+    // state of a resource after the tasks walked so far
+    struct State {
+        uint32_t writeBatch;                  // batch of the last write, UINT32_MAX if unwritten
+        std::array<uint32_t, 5> readBatch;    // last batch of each queue to read since the last write
+        VkPipelineStageFlags writeStages, readStages;
+        VkAccessFlags writeAccess, readAccess;
+        VkImageLayout layout;
+        bool used;
+        uint32_t owner;                       // queue family owning the resource
+        uint32_t lastBatch;                   // last batch to access the resource, releases ownership
+        VkPipelineStageFlags ownerStages;     // accesses since the owner acquired the resource
+        VkAccessFlags ownerAccess;
+    };
+
+    // the last batch of each queue guaranteed to have completed before the batch's wait stages
+    struct Known {
+        uint32_t batch;
+        VkPipelineStageFlags stages;
+    };
+
+    std::vector<State> states(resources.size());
+    for (State& state : states) {
+        state.writeBatch = UINT32_MAX;
+        state.readBatch.fill(UINT32_MAX);
+        state.writeStages = 0;
+        state.readStages = 0;
+        state.writeAccess = 0;
+        state.readAccess = 0;
+        state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        state.used = false;
+        state.owner = VK_QUEUE_FAMILY_IGNORED;
+        state.lastBatch = UINT32_MAX;
+        state.ownerStages = 0;
+        state.ownerAccess = 0;
+    }
+
+    std::vector<std::array<Known, 5>> known;
+    std::vector<std::vector<Barrier>> trailing; // barriers after the last task of each batch
+
+    for (Task& task : builder.tasks) {
+        if (batches.empty() || batches.back().queue != task.queue) { // begin new batch
+            uint32_t batchIndex = static_cast<uint32_t>(batches.size());
+            batches.push_back({
+                .queue = task.queue,
+                .nodeIndex = static_cast<uint32_t>(nodes.size()), .nodeCount = 0,
+                .barrierIndex = 0, .barrierCount = 0,
+                .acquireStages = 0, .present = false
+            });
+
+            std::array<Known, 5> inherited;
+            inherited.fill({ UINT32_MAX, 0 });
+
+            // semaphore waits also apply to work submitted later on the same queue
+            for (uint32_t i = batchIndex; i-- > 0;) {
+                if (batches[i].queue == task.queue) {
+                    inherited = known[i];
+                    break;
+                }
+            }
+
+            known.push_back(inherited);
+            trailing.emplace_back();
+        }
+
+        uint32_t batchIndex = static_cast<uint32_t>(batches.size() - 1);
+        Batch& batch = batches.back();
+        ++batch.nodeCount;
+
+        nodes.push_back({
+            .callback = task.callback,
+            .barrierIndex = static_cast<uint32_t>(barriers.size()),
+            .barrierCount = 0,
+            .aliasSrcStages = 0,
+            .aliasDstStages = 0
+        });
+        Node& node = nodes.back();
+        uint32_t nodeIndex = static_cast<uint32_t>(nodes.size() - 1);
+
+        // adds a semaphore from src to the current batch unless src is known to complete beforehand
+        auto depend = [&](uint32_t src, VkPipelineStageFlags stages) {
+            QueueType srcQueue = batches[src].queue;
+            Known& k = known[batchIndex][srcQueue];
+
+            if (k.batch != UINT32_MAX && k.batch >= src && (stages & ~k.stages) == 0) {
+                return;
+            }
+
+            auto it = std::find_if(edges.begin(), edges.end(), [&](const Edge& edge) {
+                return edge.dst == batchIndex && batches[edge.src].queue == srcQueue;
+            });
+
+            if (it == edges.end()) {
+                edges.push_back({ src, batchIndex, stages });
+                it = edges.end() - 1;
+            } else {
+                // waiting on the later batch of the same queue implies the earlier
+                it->src = std::max(it->src, src);
+                it->stages |= stages;
+            }
+
+            k = { it->src, it->stages };
+
+            // anything complete before src begins is also complete before this batch
+            for (uint32_t queue = 0; queue < 5; ++queue) {
+                const Known& transitive = known[it->src][queue];
+                if (transitive.batch == UINT32_MAX || queue == batch.queue) continue;
+
+                Known& current = known[batchIndex][queue];
+                if (current.batch == UINT32_MAX || current.batch < transitive.batch) {
+                    current = { transitive.batch, it->stages };
+                } else if (current.batch == transitive.batch) {
+                    current.stages |= it->stages;
+                }
+            }
+        };
+
+        auto access = [&](uint32_t resource, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stages, bool discard) {
+            State& state = states[resource];
+            uint32_t family = engine.family[task.queue];
+
+            { // extend resource lifetime
+                Lifetime& lifetime = lifetimes[resource];
+                if (lifetime.first == UINT32_MAX) {
+                    lifetime.first = nodeIndex;
+                }
+                if (lifetime.first == nodeIndex) {
+                    lifetime.firstStages |= stages;
+                }
+                if (lifetime.last != nodeIndex) {
+                    lifetime.lastStages = 0;
+                }
+                lifetime.last = nodeIndex;
+                lifetime.lastStages |= stages;
+                lifetime.queues |= 1u << task.queue;
+            }
+
+            bool write = (access & writeAccessMask) != 0;
+            bool transition = resources[resource].type != Resource::BUFFER && state.layout != layout;
+            // discarded contents need no ownership transfer, the new family simply starts using the resource.
+            // the swapchain image stays concurrent with the present queue
+            bool transfer = state.used && !discard && state.owner != family && resources[resource].type != Resource::SWAPCHAIN;
+
+            if (!state.used) { // first access in the frame
+                state.used = true;
+
+                if (resources[resource].type == Resource::SWAPCHAIN) {
+                    // layout transition must wait on the semaphore from vkAcquireNextImageKHR
+                    batch.acquireStages |= stages;
+                    barriers.push_back({
+                        resource, stages, stages, 0, access,
+                        discard ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, layout,
+                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED
+                    });
+                    ++node.barrierCount;
+                } else if (transition) {
+                    // transient resources do not keep their contents between frames
+                    barriers.push_back({
+                        resource, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, stages, 0, access,
+                        VK_IMAGE_LAYOUT_UNDEFINED, layout,
+                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED
+                    });
+                    ++node.barrierCount;
+                }
+            } else {
+                VkPipelineStageFlags srcStages = 0;
+                VkAccessFlags srcAccess = 0;
+                bool crossQueue = false;
+
+                // read after write, write after write
+                if (state.writeBatch != UINT32_MAX) {
+                    if (batches[state.writeBatch].queue == task.queue) {
+                        srcStages |= state.writeStages;
+                        srcAccess |= state.writeAccess;
+                    } else {
+                        depend(state.writeBatch, stages);
+                        crossQueue = true;
+                    }
+                }
+
+                // write after read, a layout transition counts as a write
+                if (write || transition) {
+                    for (uint32_t queue = 0; queue < 5; ++queue) {
+                        if (state.readBatch[queue] == UINT32_MAX) continue;
+
+                        if (queue == task.queue) {
+                            srcStages |= state.readStages;
+                        } else {
+                            depend(state.readBatch[queue], stages);
+                            crossQueue = true;
+                        }
+                    }
+                } else if (state.readBatch[task.queue] != UINT32_MAX && (stages & ~state.readStages) == 0 && (access & ~state.readAccess) == 0) {
+                    // read after read, the write was already made visible to these stages by an earlier barrier
+                    srcStages = 0;
+                    srcAccess = 0;
+                }
+
+                // semaphore waits make memory available and visible, only the layout transition must chain onto it
+                if (crossQueue && transition) {
+                    srcStages |= stages;
+                }
+
+                if (transfer) {
+                    // release after the owner's last access, acquire chains onto the semaphore wait.
+                    // both halves carry the same layout transition, which is performed once
+                    depend(state.lastBatch, stages);
+
+                    trailing[state.lastBatch].push_back({
+                        resource, state.ownerStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        state.ownerAccess, 0, state.layout, layout,
+                        state.owner, family
+                    });
+                    barriers.push_back({
+                        resource, srcStages | stages, stages,
+                        0, access, state.layout, layout,
+                        state.owner, family
+                    });
+                    ++node.barrierCount;
+                } else if (srcStages != 0 || transition) {
+                    barriers.push_back({
+                        resource, srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, stages,
+                        srcAccess, access, discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout, layout,
+                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED
+                    });
+                    ++node.barrierCount;
+                }
+            }
+
+            if (state.owner != family) {
+                state.owner = family;
+                state.ownerStages = 0;
+                state.ownerAccess = 0;
+            }
+            state.lastBatch = batchIndex;
+            state.ownerStages |= stages;
+            state.ownerAccess |= access & writeAccessMask;
+
+            if (write || transition) {
+                state.writeBatch = batchIndex;
+                state.readBatch.fill(UINT32_MAX);
+                state.writeStages = stages;
+                state.writeAccess = access;
+                state.readStages = 0;
+                state.readAccess = 0;
+            }
+
+            if (!write) {
+                state.readBatch[task.queue] = batchIndex;
+                state.readStages |= stages;
+                state.readAccess |= access;
+            }
+
+            state.layout = layout;
+        };
+
+        for (auto& [resource, usage] : task.images) {
+            access(resource, usage.layout, usage.access, usage.stages, usage.loadop != VK_ATTACHMENT_LOAD_OP_LOAD);
+        }
+
+        for (auto& [resource, usage] : task.buffers) {
+            access(resource, VK_IMAGE_LAYOUT_UNDEFINED, usage.access, usage.stages, usage.loadop != VK_ATTACHMENT_LOAD_OP_LOAD);
+        }
+    }
+
+    presents = false;
+
+    { // transition swapchain image to present after its last use
+        for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+            if (resources[resource].type != Resource::SWAPCHAIN || !states[resource].used) continue;
+
+            State& state = states[resource];
+            uint32_t last = state.writeBatch;
+            for (uint32_t batch : state.readBatch) {
+                if (batch != UINT32_MAX && (last == UINT32_MAX || batch > last)) last = batch;
+            }
+
+            batches[last].present = true;
+            presents = true;
+
+            trailing[last].push_back({
+                resource, state.writeStages | state.readStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                state.writeAccess, 0, state.layout, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED
+            });
+        }
+    }
+
+    { // append trailing barriers
+        for (uint32_t i = 0; i < batches.size(); ++i) {
+            batches[i].barrierIndex = static_cast<uint32_t>(barriers.size());
+            batches[i].barrierCount = static_cast<uint32_t>(trailing[i].size());
+            barriers.insert(barriers.end(), trailing[i].begin(), trailing[i].end());
+        }
+    }
+
+    LOG("render graph: " << nodes.size() << " tasks, " << batches.size() << " submits, " << edges.size() << " cross queue waits, " << barriers.size() << " barriers")
+}
+
+void Render::Graph::allocate() {
+    handles.resize(frameCount * resources.size(), Handle{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, UINT32_MAX });
+    stats = { 0, 0, 0 };
+
+    std::vector<VkMemoryRequirements> requirements(resources.size());
+
+    { // create resources without memory, resources no task uses are left null
+        for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+            const Resource& desc = resources[resource];
+            if (lifetimes[resource].first == UINT32_MAX) continue;
+
+            for (uint32_t frame = 0; frame < frameCount; ++frame) {
+                Handle& handle = handles[frame * resources.size() + resource];
+
+                switch (desc.type) {
+                    case Resource::BUFFER: {
+                        VkBufferCreateInfo info {
+                            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                            .size = desc.size,
+                            .usage = desc.usage,
+                            .sharingMode = VK_SHARING_MODE_EXCLUSIVE, // ownership is transferred between families by the compiled barriers
+                            .queueFamilyIndexCount = 0,
+                            .pQueueFamilyIndices = nullptr
+                        };
+
+                        VK_ASSERT(vkCreateBuffer(engine.device, &info, nullptr, &handle.buffer));
+                        vkGetBufferMemoryRequirements(engine.device, handle.buffer, &requirements[resource]);
+                        break;
+                    }
+                    case Resource::IMAGE:
+                    case Resource::ATTACHMENT: {
+                        VkImageCreateInfo info {
+                            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                            .imageType = VK_IMAGE_TYPE_2D,
+                            .format = desc.format,
+                            .extent  = { desc.x, desc.y, desc.z },
+                            .mipLevels = desc.levels,
+                            .arrayLayers = 1,
+                            .samples = static_cast<VkSampleCountFlagBits>(desc.samples),
+                            .tiling = VK_IMAGE_TILING_OPTIMAL,
+                            .usage = desc.usage,
+                            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                            .queueFamilyIndexCount = 0,
+                            .pQueueFamilyIndices = nullptr,
+                            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                        };
+
+                        VK_ASSERT(vkCreateImage(engine.device, &info, nullptr, &handle.image));
+                        vkGetImageMemoryRequirements(engine.device, handle.image, &requirements[resource]);
+                        break;
+                    }
+                    case Resource::SWAPCHAIN: {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> aliased;
+    { // allocate lazily allocated memory for transient attachments
+        for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+            const Resource& desc = resources[resource];
+            if (desc.type == Resource::SWAPCHAIN || lifetimes[resource].first == UINT32_MAX) continue;
+
+            stats.naive += requirements[resource].size * frameCount;
+
+            if (desc.type != Resource::ATTACHMENT || !(desc.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)) {
+                aliased.push_back(resource);
+                continue;
+            }
+
+            VmaAllocationCreateInfo alloc {
+                .usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED
+            };
+
+            // falls back to aliasing if the device has no lazily allocated memory type, eg desktop gpus
+            VkResult res = VK_SUCCESS;
+            for (uint32_t frame = 0; frame < frameCount && res == VK_SUCCESS; ++frame) {
+                Handle& handle = handles[frame * resources.size() + resource];
+                res = vmaAllocateMemoryForImage(engine.allocator, handle.image, &alloc, &handle.allocation, nullptr);
+                if (res == VK_SUCCESS) {
+                    VK_ASSERT(vmaBindImageMemory(engine.allocator, handle.allocation, handle.image));
+                }
+            }
+
+            if (res == VK_SUCCESS) {
+                stats.lazy += requirements[resource].size * frameCount;
+                continue;
+            }
+
+            for (uint32_t frame = 0; frame < frameCount; ++frame) {
+                Handle& handle = handles[frame * resources.size() + resource];
+                if (handle.allocation != VK_NULL_HANDLE) {
+                    vmaFreeMemory(engine.allocator, handle.allocation);
+                    handle.allocation = VK_NULL_HANDLE;
+                }
+            }
+            aliased.push_back(resource);
+        }
+    }
+
+    struct Placement {
+        uint32_t heap;
+        VkDeviceSize offset;
+    };
+
+    struct Heap {
+        bool images; // buffers and images are kept apart to sidestep bufferImageGranularity
+        uint32_t memoryTypeBits;
+        VkDeviceSize size, alignment;
+        std::vector<uint32_t> resources;
+    };
+
+    std::vector<Placement> placements(resources.size(), Placement{ UINT32_MAX, 0 });
+    std::vector<Heap> layout;
+
+    { // place resources in shared heaps, resources may overlap in memory if their lifetimes do not
+        // resources used on one queue can alias, the dependency between them is a pipeline barrier
+        auto overlaps = [&](uint32_t lhs, uint32_t rhs) {
+            const Lifetime& a = lifetimes[lhs];
+            const Lifetime& b = lifetimes[rhs];
+            if (a.queues != b.queues || std::popcount(a.queues) != 1) return true;
+            return a.first <= b.last && b.first <= a.last;
+        };
+
+        // largest first packs better
+        std::sort(aliased.begin(), aliased.end(), [&](uint32_t lhs, uint32_t rhs) {
+            return requirements[lhs].size > requirements[rhs].size;
+        });
+
+        for (uint32_t resource : aliased) {
+            const VkMemoryRequirements& req = requirements[resource];
+
+            for (uint32_t heap = 0; heap < layout.size() && placements[resource].heap == UINT32_MAX; ++heap) {
+                if (!(layout[heap].memoryTypeBits & req.memoryTypeBits) || layout[heap].images != (resources[resource].type != Resource::BUFFER)) continue;
+
+                // memory ranges occupied by resources alive at the same time
+                std::vector<std::pair<VkDeviceSize, VkDeviceSize>> occupied;
+                for (uint32_t other : layout[heap].resources) {
+                    if (overlaps(resource, other)) {
+                        occupied.emplace_back(placements[other].offset, placements[other].offset + requirements[other].size);
+                    }
+                }
+                std::sort(occupied.begin(), occupied.end());
+
+                // first fit
+                VkDeviceSize offset = 0;
+                for (auto [begin, end] : occupied) {
+                    if (offset + req.size <= begin) break;
+                    offset = std::max(offset, (end + req.alignment - 1) / req.alignment * req.alignment);
+                }
+
+                placements[resource] = { heap, offset };
+            }
+
+            if (placements[resource].heap == UINT32_MAX) {
+                placements[resource] = { static_cast<uint32_t>(layout.size()), 0 };
+                layout.push_back({ resources[resource].type != Resource::BUFFER, req.memoryTypeBits, 0, 1, {} });
+            }
+
+            Heap& heap = layout[placements[resource].heap];
+            heap.memoryTypeBits &= req.memoryTypeBits;
+            heap.size = std::max(heap.size, placements[resource].offset + req.size);
+            heap.alignment = std::max(heap.alignment, req.alignment);
+            heap.resources.push_back(resource);
+        }
+    }
+
+    { // synchronize resources reusing memory from a resource whose lifetime has ended
+        for (const Heap& heap : layout) {
+            for (uint32_t resource : heap.resources) {
+                const Placement& a = placements[resource];
+                for (uint32_t other : heap.resources) {
+                    const Placement& b = placements[other];
+                    bool sharesMemory = a.offset < b.offset + requirements[other].size && b.offset < a.offset + requirements[resource].size;
+                    if (other == resource || !sharesMemory || lifetimes[other].last >= lifetimes[resource].first) continue;
+
+                    Node& node = nodes[lifetimes[resource].first];
+                    node.aliasSrcStages |= lifetimes[other].lastStages;
+                    node.aliasDstStages |= lifetimes[resource].firstStages;
+                }
+            }
+        }
+    }
+
+    { // allocate heaps and bind resources
+        heaps.resize(frameCount * layout.size());
+
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            for (uint32_t i = 0; i < layout.size(); ++i) {
+                VkMemoryRequirements req {
+                    .size = layout[i].size,
+                    .alignment = layout[i].alignment,
+                    .memoryTypeBits = layout[i].memoryTypeBits
+                };
+
+                VmaAllocationCreateInfo alloc {
+                    .usage = VMA_MEMORY_USAGE_GPU_ONLY
+                };
+
+                VmaAllocation& heap = heaps[frame * layout.size() + i];
+                VK_ASSERT(vmaAllocateMemory(engine.allocator, &req, &alloc, &heap, nullptr));
+
+                for (uint32_t resource : layout[i].resources) {
+                    Handle& handle = handles[frame * resources.size() + resource];
+                    if (handle.image != VK_NULL_HANDLE) {
+                        VK_ASSERT(vmaBindImageMemory2(engine.allocator, heap, placements[resource].offset, handle.image, nullptr));
+                    } else {
+                        VK_ASSERT(vmaBindBufferMemory2(engine.allocator, heap, placements[resource].offset, handle.buffer, nullptr));
+                    }
+                }
+            }
+        }
+
+        for (const Heap& heap : layout) {
+            stats.aliased += heap.size * frameCount;
+        }
+    }
+
+    { // create image views
+        for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+            const Resource& desc = resources[resource];
+            if ((desc.type != Resource::IMAGE && desc.type != Resource::ATTACHMENT) || lifetimes[resource].first == UINT32_MAX) continue;
+
+            for (uint32_t frame = 0; frame < frameCount; ++frame) {
+                Handle& handle = handles[frame * resources.size() + resource];
+
+                VkImageViewCreateInfo info {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                    .image = handle.image,
+                    .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                    .format = desc.format,
+                    .subresourceRange = { aspectMask(desc.format), 0, desc.levels, 0, 1 }
+                };
+
+                VK_ASSERT(vkCreateImageView(engine.device, &info, nullptr, &handle.view));
+
+                if (desc.levels == 1) continue;
+
+                // per level views for passes writing one level while reading another, eg a depth pyramid
+                handle.levelViews = static_cast<uint32_t>(levelViews.size());
+                for (uint32_t level = 0; level < desc.levels; ++level) {
+                    info.subresourceRange = { aspectMask(desc.format), level, 1, 0, 1 };
+                    VK_ASSERT(vkCreateImageView(engine.device, &info, nullptr, &levelViews.emplace_back()));
+                }
+            }
+        }
+    }
+
+    LOG("render graph memory: naive " << (stats.naive >> 20) << "MB, aliased " << (stats.aliased >> 20) << "MB, lazy " << (stats.lazy >> 20) << "MB, saved " << ((stats.naive - stats.aliased - stats.lazy) >> 20) << "MB")
+
+    { // get swapchain images
+        VK_ASSERT(vkGetSwapchainImagesKHR(engine.device, swapchain.swapchain, &imageCount, nullptr));
+        images.resize(imageCount);
+        VK_ASSERT(vkGetSwapchainImagesKHR(engine.device, swapchain.swapchain, &imageCount, images.data()));
+
+        presented.assign(imageCount, false);
+        imageViews.resize(imageCount);
+        for (uint32_t i = 0; i < imageCount; ++i) {
+            VkImageViewCreateInfo info {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = images[i],
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = swapchain.format,
+                .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+            };
+
+            VK_ASSERT(vkCreateImageView(engine.device, &info, nullptr, &imageViews[i]));
+        }
+    }
+}
+
+bool Render::Graph::render() {
+    const uint64_t timeout = 1000000000;
+    uint32_t batchCount = static_cast<uint32_t>(batches.size());
+    uint32_t edgeCount = static_cast<uint32_t>(edges.size());
+
+    wait(frameIndex, timeout);
+
+    if (presents) { // acquire image
+        VkResult res = vkAcquireNextImageKHR(engine.device, swapchain.swapchain, timeout, imageReady[frameIndex], nullptr, &imageIndex);
+
+        if (res == VK_ERROR_OUT_OF_DATE_KHR) {
+            return false;
+        } else if (res != VK_SUBOPTIMAL_KHR) {
+            VK_ASSERT(res);
+        }
+    }
+
+    { // recycle the frame's secondary command buffers and descriptor sets
+        for (uint32_t thread = 0; thread < workers.size(); ++thread) {
+            Recorder& recorder = recorders[frameIndex * workers.size() + thread];
+            for (uint32_t queue = 0; queue < 5; ++queue) {
+                if (recorder.used[queue] == 0) continue;
+
+                VK_ASSERT(vkResetCommandPool(engine.device, recorder.pools[queue], 0));
+                recorder.used[queue] = 0;
+            }
+        }
+
+        descriptors.reset(frameIndex);
+    }
+
+    // uploads consumed by this frame, acquired by the first batch on each queue
+    uint32_t queues = 0;
+    for (const Batch& batch : batches) {
+        queues |= 1u << batch.queue;
+    }
+    uint64_t transferValue = staging != nullptr ? staging->flush(queues) : 0;
+    bool firstOnQueue[5] = { true, true, true, true, true };
+
+    { // record command buffers
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+        auto record = [&](VkCommandBuffer cmd, uint32_t index, uint32_t count, VkPipelineStageFlags aliasSrcStages, VkPipelineStageFlags aliasDstStages) {
+            if (count == 0 && aliasSrcStages == 0) return;
+
+            imageBarriers.clear();
+            bufferBarriers.clear();
+            VkPipelineStageFlags srcStages = aliasSrcStages, dstStages = aliasDstStages;
+
+            // previous contents of aliased memory are discarded, only the execution and write ordering matters
+            VkMemoryBarrier aliasBarrier {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+            };
+
+            for (uint32_t i = index; i < index + count; ++i) {
+                const Barrier& barrier = barriers[i];
+                const Resource& resource = resources[barrier.resource];
+                srcStages |= barrier.srcStages;
+                dstStages |= barrier.dstStages;
+
+                if (resource.type == Resource::BUFFER) {
+                    bufferBarriers.push_back({
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                        .pNext = nullptr,
+                        .srcAccessMask = barrier.srcAccess,
+                        .dstAccessMask = barrier.dstAccess,
+                        .srcQueueFamilyIndex = barrier.srcFamily == barrier.dstFamily ? VK_QUEUE_FAMILY_IGNORED : barrier.srcFamily,
+                        .dstQueueFamilyIndex = barrier.srcFamily == barrier.dstFamily ? VK_QUEUE_FAMILY_IGNORED : barrier.dstFamily,
+                        .buffer = buffer(barrier.resource, frameIndex),
+                        .offset = 0,
+                        .size = VK_WHOLE_SIZE
+                    });
+                } else {
+                    VkFormat format = resource.type == Resource::SWAPCHAIN ? swapchain.format : resource.format;
+
+                    // a swapchain image loaded before it was ever presented has no contents yet
+                    VkImageLayout oldLayout = barrier.oldLayout;
+                    if (resource.type == Resource::SWAPCHAIN && oldLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR && !presented[imageIndex]) {
+                        oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                    }
+
+                    imageBarriers.push_back({
+                        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                        .pNext = nullptr,
+                        .srcAccessMask = barrier.srcAccess,
+                        .dstAccessMask = barrier.dstAccess,
+                        .oldLayout = oldLayout,
+                        .newLayout = barrier.newLayout,
+                        .srcQueueFamilyIndex = barrier.srcFamily == barrier.dstFamily ? VK_QUEUE_FAMILY_IGNORED : barrier.srcFamily,
+                        .dstQueueFamilyIndex = barrier.srcFamily == barrier.dstFamily ? VK_QUEUE_FAMILY_IGNORED : barrier.dstFamily,
+                        .image = image(barrier.resource, frameIndex),
+                        .subresourceRange = { aspectMask(format), 0, resource.levels, 0, 1 }
+                    });
+                }
+            }
+
+            vkCmdPipelineBarrier(cmd, srcStages, dstStages, 0,
+                aliasSrcStages ? 1 : 0, &aliasBarrier,
+                static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+            );
+        };
+
+        for (uint32_t i = 0; i < batchCount; ++i) {
+            const Batch& batch = batches[i];
+            VkCommandBuffer cmd = commands[frameIndex * batchCount + i];
+
+            { // reset & begin cmd buffer
+                VK_ASSERT(vkResetCommandBuffer(cmd, 0));
+
+                VkCommandBufferBeginInfo info{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                    .pNext = nullptr,
+                    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                    .pInheritanceInfo = nullptr
+                };
+                VK_ASSERT(vkBeginCommandBuffer(cmd, &info));
+            }
+
+            if (staging != nullptr && firstOnQueue[batch.queue]) {
+                staging->acquire(cmd, batch.queue);
+            }
+            firstOnQueue[batch.queue] = false;
+
+            for (uint32_t j = batch.nodeIndex; j < batch.nodeIndex + batch.nodeCount; ++j) {
+                const Node& node = nodes[j];
+                record(cmd, node.barrierIndex, node.barrierCount, node.aliasSrcStages, node.aliasDstStages);
+
+                if (node.callback) {
+                    node.callback(Task::Context{ cmd, batch.queue, frameIndex, imageIndex, 0, *this });
+                }
+            }
+
+            record(cmd, batch.barrierIndex, batch.barrierCount, 0, 0);
+
+            VK_ASSERT(vkEndCommandBuffer(cmd));
+        }
+    }
+
+    { // submit command buffers
+        std::vector<VkSemaphore> waits, signals;
+        std::vector<uint64_t> waitValues, signalValues; // ignored for binary semaphores
+        std::vector<VkPipelineStageFlags> stages;
+
+        std::fill(std::begin(firstOnQueue), std::end(firstOnQueue), true);
+
+        for (uint32_t i = 0; i < batchCount; ++i) {
+            const Batch& batch = batches[i];
+            uint64_t& value = values[frameIndex * batchCount + i];
+            value = ++engine.value[batch.queue];
+
+            waits.clear();
+            waitValues.clear();
+            signals.clear();
+            signalValues.clear();
+            stages.clear();
+
+            if (batch.acquireStages != 0) {
+                waits.push_back(imageReady[frameIndex]);
+                waitValues.push_back(0);
+                stages.push_back(batch.acquireStages);
+            }
+
+            // later batches on the queue are ordered after the first one's wait
+            if (transferValue != 0 && firstOnQueue[batch.queue]) {
+                waits.push_back(engine.timeline[TRANSFER]);
+                waitValues.push_back(transferValue);
+                stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+            }
+            firstOnQueue[batch.queue] = false;
+
+            // src batches are submitted first, so their values for this frame are already known
+            for (uint32_t j = 0; j < edgeCount; ++j) {
+                if (edges[j].dst == i) {
+                    waits.push_back(engine.timeline[batches[edges[j].src].queue]);
+                    waitValues.push_back(values[frameIndex * batchCount + edges[j].src]);
+                    stages.push_back(edges[j].stages);
+                }
+            }
+
+            signals.push_back(engine.timeline[batch.queue]);
+            signalValues.push_back(value);
+
+            if (batch.present) {
+                signals.push_back(frameReady[frameIndex]);
+                signalValues.push_back(0);
+            }
+
+            VkTimelineSemaphoreSubmitInfo timelineInfo{
+                .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                .pNext = nullptr,
+                .waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size()),
+                .pWaitSemaphoreValues = waitValues.data(),
+                .signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size()),
+                .pSignalSemaphoreValues = signalValues.data()
+            };
+
+            VkSubmitInfo info{
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .pNext = &timelineInfo,
+                .waitSemaphoreCount = static_cast<uint32_t>(waits.size()),
+                .pWaitSemaphores = waits.data(),
+                .pWaitDstStageMask = stages.data(),
+                .commandBufferCount = 1,
+                .pCommandBuffers = &commands[frameIndex * batchCount + i],
+                .signalSemaphoreCount = static_cast<uint32_t>(signals.size()),
+                .pSignalSemaphores = signals.data()
+            };
+
+            VK_ASSERT(vkQueueSubmit(engine.queue[batch.queue], 1, &info, VK_NULL_HANDLE));
+        }
+    }
+
+    bool outdated = false;
+    if (presents) { // present to screen
+        VkPresentInfoKHR info{
+            .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            .pNext = nullptr,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &frameReady[frameIndex],
+            .swapchainCount = 1,
+            .pSwapchains = &swapchain.swapchain,
+            .pImageIndices = &imageIndex,
+            .pResults = nullptr
+        };
+        VkResult res = vkQueuePresentKHR(engine.queue[PRESENT], &info);
+        presented[imageIndex] = true;
+
+        if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) {
+            outdated = true;
+        } else {
+            VK_ASSERT(res);
+        }
+    }
+
+    frameIndex = (frameIndex + 1) % frameCount;
+
+    return !outdated;
+}
+
+void Render::Graph::stream(StagingRing& ring) {
+    staging = &ring;
+}
+
+void Render::Graph::wait(uint32_t frame, uint64_t timeout) const {
+    // only the last submit per queue matters, the timelines are monotonic
+    uint64_t last[5] = { 0, 0, 0, 0, 0 };
+    for (uint32_t i = 0; i < batches.size(); ++i) {
+        last[batches[i].queue] = std::max(last[batches[i].queue], values[frame * batches.size() + i]);
+    }
+
+    VkSemaphore waits[5];
+    uint64_t waitValues[5];
+    uint32_t count = 0;
+    for (uint32_t queue = 0; queue < 5; ++queue) {
+        if (last[queue] == 0) continue;
+        waits[count] = engine.timeline[queue];
+        waitValues[count] = last[queue];
+        ++count;
+    }
+
+    if (count == 0) return;
+
+    VkSemaphoreWaitInfo info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .semaphoreCount = count,
+        .pSemaphores = waits,
+        .pValues = waitValues
+    };
+    VK_ASSERT(vkWaitSemaphores(engine.device, &info, timeout));
+}
+
+void Render::Task::Context::parallel(uint32_t count, uint32_t chunk, const Inheritance& inheritance, const Record& record) const {
+    graph.parallel(*this, count, chunk, inheritance, record);
+}
+
+VkDescriptorSet Render::Task::Context::descriptor(const Program& program, uint32_t set) const {
+    return graph.descriptors.allocate(frameIndex, thread, program, set);
+}
+
+void Render::Graph::parallel(const Task::Context& context, uint32_t count, uint32_t chunk, const Task::Inheritance& inheritance, const Task::Record& record) {
+    uint32_t chunkCount = (count + chunk - 1) / chunk;
+    if (chunkCount == 0) return;
+
+    std::vector<VkCommandBuffer> secondaries(chunkCount);
+
+    workers.dispatch(chunkCount, [&](uint32_t thread, uint32_t index) {
+        Recorder& recorder = recorders[context.frameIndex * workers.size() + thread];
+        std::vector<VkCommandBuffer>& buffers = recorder.buffers[context.queue];
+        uint32_t& used = recorder.used[context.queue];
+
+        if (used == buffers.size()) { // pools are owned by the thread, grow without locking
+            VkCommandBufferAllocateInfo info{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .pNext = nullptr,
+                .commandPool = recorder.pools[context.queue],
+                .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                .commandBufferCount = 1
+            };
+            VK_ASSERT(vkAllocateCommandBuffers(engine.device, &info, &buffers.emplace_back()));
+        }
+
+        VkCommandBuffer cmd = buffers[used++];
+
+        { // begin secondary cmd buffer
+            VkCommandBufferInheritanceInfo inheritanceInfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                .pNext = nullptr,
+                .renderPass = inheritance.renderPass,
+                .subpass = inheritance.subpass,
+                .framebuffer = inheritance.framebuffer,
+                .occlusionQueryEnable = VK_FALSE,
+                .queryFlags = 0,
+                .pipelineStatistics = 0
+            };
+
+            VkCommandBufferBeginInfo info{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = nullptr,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | (inheritance.renderPass != VK_NULL_HANDLE ? VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT : 0u),
+                .pInheritanceInfo = &inheritanceInfo
+            };
+            VK_ASSERT(vkBeginCommandBuffer(cmd, &info));
+        }
+
+        uint32_t begin = index * chunk;
+        record(Task::Context{ cmd, context.queue, context.frameIndex, context.imageIndex, thread, *this }, begin, std::min(begin + chunk, count));
+
+        VK_ASSERT(vkEndCommandBuffer(cmd));
+        secondaries[index] = cmd;
+    });
+
+    vkCmdExecuteCommands(context.cmd, chunkCount, secondaries.data());
+}
+
+VkImage Render::Graph::image(uint32_t resource, uint32_t frameIndex) const {
+    if (resources[resource].type == Resource::SWAPCHAIN) {
+        return images[imageIndex];
+    }
+    return handles[frameIndex * resources.size() + resource].image;
+}
+
+VkImageView Render::Graph::view(uint32_t resource, uint32_t frameIndex) const {
+    if (resources[resource].type == Resource::SWAPCHAIN) {
+        return imageViews[imageIndex];
+    }
+    return handles[frameIndex * resources.size() + resource].view;
+}
+
+VkImageView Render::Graph::view(uint32_t resource, uint32_t frameIndex, uint32_t level) const {
+    const Handle& handle = handles[frameIndex * resources.size() + resource];
+    if (handle.levelViews == UINT32_MAX) {
+        return view(resource, frameIndex);
+    }
+    return levelViews[handle.levelViews + level];
+}
+
+VkBuffer Render::Graph::buffer(uint32_t resource, uint32_t frameIndex) const {
+    return handles[frameIndex * resources.size() + resource].buffer;
+}
+
+const Render::Graph::Statistics& Render::Graph::statistics() const {
+    return stats;
+}
@@ -0,0 +1,101 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/resources/descriptor.h>
+#include <algorithm>
+
+static void growSizes(std::vector<std::pair<VkDescriptorType, uint32_t>>& sizes, const Arawn::Program::Set& set) {
+	for (auto [type, count] : set.counts) {
+		auto it = std::find_if(sizes.begin(), sizes.end(), [&](const auto& size) { return size.first == type; });
+		if (it == sizes.end()) {
+			sizes.emplace_back(type, count);
+		} else {
+			it->second = std::max(it->second, count);
+		}
+	}
+}
+
+Arawn::DescriptorAllocator::DescriptorAllocator(uint32_t frameCount, uint32_t threadCount, uint32_t setsPerPool)
+ : threadCount(threadCount), frames(frameCount * threadCount, Pools{ {}, 0, setsPerPool, {} })
+{ }
+
+Arawn::DescriptorAllocator::~DescriptorAllocator() {
+	for (Pools& frame : frames) {
+		for (VkDescriptorPool pool : frame.pools) {
+			vkDestroyDescriptorPool(engine.device, pool, nullptr);
+		}
+	}
+}
+
+void Arawn::DescriptorAllocator::reset(uint32_t frameIndex) {
+	for (uint32_t thread = 0; thread < threadCount; ++thread) {
+		Pools& frame = frames[frameIndex * threadCount + thread];
+		for (uint32_t i = 0; i <= frame.active && i < frame.pools.size(); ++i) {
+			VK_ASSERT(vkResetDescriptorPool(engine.device, frame.pools[i], 0));
+		}
+		frame.active = 0;
+	}
+}
+
+VkDescriptorSet Arawn::DescriptorAllocator::allocate(uint32_t frameIndex, uint32_t thread, const Program& program, uint32_t set) {
+	const Program::Set& desc = program.sets[set];
+	Pools& frame = frames[frameIndex * threadCount + thread];
+
+	// sized by its owner, would inflate every frame pool and leave the runtime array without a variable count
+	if (desc.bindless) {
+		throw std::runtime_error("bindless descriptor sets are allocated by their owner, not per frame");
+	}
+
+	// the next pool created fits every program seen so far
+	growSizes(frame.sizes, desc);
+
+	// full pools are skipped until the frame is reset
+	for (bool created = false; ; ) {
+		if (frame.active == frame.pools.size()) {
+			frame.pools.push_back(create(frame));
+			created = true;
+		}
+
+		VkDescriptorSetAllocateInfo info {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.descriptorPool = frame.pools[frame.active],
+			.descriptorSetCount = 1,
+			.pSetLayouts = &desc.layout
+		};
+
+		VkDescriptorSet descriptorSet;
+		VkResult res = vkAllocateDescriptorSets(engine.device, &info, &descriptorSet);
+
+		if (res == VK_SUCCESS) {
+			return descriptorSet;
+		}
+
+		if ((res != VK_ERROR_OUT_OF_POOL_MEMORY && res != VK_ERROR_FRAGMENTED_POOL) || created) {
+			VK_ASSERT(res);
+		}
+
+		++frame.active;
+	}
+}
+
+VkDescriptorPool Arawn::DescriptorAllocator::create(Pools& frame) {
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	for (auto [type, count] : frame.sizes) {
+		if (count == 0) continue;
+		poolSizes.push_back({ type, count * frame.setsPerPool });
+	}
+
+	VkDescriptorPoolCreateInfo info {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.flags = 0,
+		.maxSets = frame.setsPerPool,
+		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+		.pPoolSizes = poolSizes.data()
+	};
+
+	VkDescriptorPool pool;
+	VK_ASSERT(vkCreateDescriptorPool(engine.device, &info, nullptr, &pool));
+
+	// later pools grow, so long frames settle on few pools
+	frame.setsPerPool = std::min(frame.setsPerPool * 2, 4096u);
+
+	return pool;
+}
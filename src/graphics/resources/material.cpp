@@ -0,0 +1,127 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/resources/material.h>
+#include <algorithm>
+
+static_assert(sizeof(Arawn::Material) == 48, "material must match the std430 shader layout");
+
+constexpr uint32_t albedoTextureFlag    = 0x00000001;
+constexpr uint32_t metallicTextureFlag  = 0x00000002;
+constexpr uint32_t roughnessTextureFlag = 0x00000004;
+constexpr uint32_t normalTextureFlag    = 0x00000008;
+
+Arawn::MaterialTable::MaterialTable(const Program& program, uint32_t set, StagingRing& staging, uint32_t capacity)
+ : staging(staging), set(set), textureCapacity(0), textureCount(0), materialCapacity(capacity), materialCount(0),
+   materials(capacity * sizeof(Material), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY)
+{
+	const Program::Set& desc = program.sets[set];
+
+	{ // create sampler shared by every texture
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(engine.gpu, &properties);
+
+		VkSamplerCreateInfo info {
+			.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+			.magFilter = VK_FILTER_LINEAR,
+			.minFilter = VK_FILTER_LINEAR,
+			.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+			.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+			.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+			.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+			.anisotropyEnable = VK_TRUE,
+			.maxAnisotropy = properties.limits.maxSamplerAnisotropy,
+			.maxLod = VK_LOD_CLAMP_NONE
+		};
+
+		VK_ASSERT(vkCreateSampler(engine.device, &info, nullptr, &sampler));
+	}
+
+	{ // create pool holding the single set, its texture array is written while the set is bound
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (auto [type, count] : desc.counts) {
+			poolSizes.push_back({ type, count });
+
+			if (type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
+				textureCapacity = std::max(textureCapacity, count);
+			}
+		}
+
+		VkDescriptorPoolCreateInfo info {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+			.maxSets = 1,
+			.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+			.pPoolSizes = poolSizes.data()
+		};
+
+		VK_ASSERT(vkCreateDescriptorPool(engine.device, &info, nullptr, &pool));
+	}
+
+	{ // allocate set and bind the material buffer
+		VkDescriptorSetAllocateInfo info {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.descriptorPool = pool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &desc.layout
+		};
+
+		VK_ASSERT(vkAllocateDescriptorSets(engine.device, &info, &descriptorSet));
+
+		VkDescriptorBufferInfo bufferInfo { materials.buffer, 0, VK_WHOLE_SIZE };
+
+		VkWriteDescriptorSet write {
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = descriptorSet,
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.pBufferInfo = &bufferInfo
+		};
+
+		vkUpdateDescriptorSets(engine.device, 1, &write, 0, nullptr);
+	}
+}
+
+Arawn::MaterialTable::~MaterialTable() {
+	vkDestroyDescriptorPool(engine.device, pool, nullptr);
+	vkDestroySampler(engine.device, sampler, nullptr);
+}
+
+uint32_t Arawn::MaterialTable::texture(const Image& image) {
+	if (textureCount == textureCapacity) throw std::runtime_error("bindless texture array is full");
+
+	VkDescriptorImageInfo imageInfo { sampler, image.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+	VkWriteDescriptorSet write {
+		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		.dstSet = descriptorSet,
+		.dstBinding = 1,
+		.dstArrayElement = textureCount,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.pImageInfo = &imageInfo
+	};
+
+	vkUpdateDescriptorSets(engine.device, 1, &write, 0, nullptr);
+
+	return textureCount++;
+}
+
+uint32_t Arawn::MaterialTable::material(const Material& material) {
+	if (materialCount == materialCapacity) throw std::runtime_error("material buffer is full");
+
+	Material data = material;
+	data.flags = 0;
+	if (data.albedoMap != Material::none)    data.flags |= albedoTextureFlag;
+	if (data.metallicMap != Material::none)  data.flags |= metallicTextureFlag;
+	if (data.roughnessMap != Material::none) data.flags |= roughnessTextureFlag;
+	if (data.normalMap != Material::none)    data.flags |= normalTextureFlag;
+
+	staging.upload(materials, &data, sizeof(Material), materialCount * sizeof(Material));
+
+	return materialCount++;
+}
+
+void Arawn::MaterialTable::bind(VkCommandBuffer cmd, const Program& program) const {
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, program.layout, set, 1, &descriptorSet, 0, nullptr);
+}
@@ -1,18 +1,24 @@
 #define ARAWN_IMPLEMENTATION
 #include <graphics/resources/program.h>
 #include <graphics/engine.h>
+#include <util/json.h>
 #include <spirv_reflect.h>
 #include <fstream>
 #include <algorithm>
+#include <array>
+#include <cstddef>
 
-SpvReflectShaderModule loadShader(const char* filepath) {
+// written by the build, lists the spir-v compiled from each shader source and permutation
+#ifndef SHADER_MANIFEST_PATH
+#define SHADER_MANIFEST_PATH "res/import/shader/manifest.json"
+#endif
+
+SpvReflectShaderModule loadShader(const char* filepath, std::vector<uint32_t>& code) {
 	std::ifstream file(filepath, std::ios::ate | std::ios::binary);
 	if (!file.is_open()) throw std::runtime_error("failed to open shader file");
 
-	std::vector<uint32_t> code;
-
 	std::size_t fileSize = (std::size_t)file.tellg();
-	code.resize(fileSize);
+	code.resize(fileSize / sizeof(uint32_t));
 
 	file.seekg(0);
 	file.read((char*)code.data(), fileSize);
@@ -29,13 +35,19 @@ SpvReflectShaderModule loadShader(const char* filepath) {
 	return module;
 }
 
-VkPipelineLayout createLayout(const std::vector<const SpvReflectShaderModule*>& stages) {
+// descriptor count of runtime sized arrays, eg the bindless texture table
+constexpr uint32_t bindlessCount = 4096;
+
+VkPipelineLayout createLayout(const std::vector<const SpvReflectShaderModule*>& stages, std::vector<Arawn::Program::Set>& sets) {
 	using namespace Arawn;
 	using bindingMap_t = std::pair<uint32_t, std::vector<VkDescriptorSetLayoutBinding>>;
 	using setMap_t = std::vector<bindingMap_t>;
 	setMap_t setMap;
+	std::vector<VkPushConstantRange> ranges;
 	
 	for (const auto* stage : stages) {
+		VkShaderStageFlags stageFlag = static_cast<VkShaderStageFlags>(stage->shader_stage);
+
 		uint32_t setCount;
 		spvReflectEnumerateDescriptorSets(stage, &setCount, nullptr);
 		
@@ -48,7 +60,7 @@ VkPipelineLayout createLayout(const std::vector<const SpvReflectShaderModule*>&
 
 			auto it = std::find_if(setMap.begin(), setMap.end(), [=](const auto& setMap) { return setMap.first == setIndex; });
 			if (it == setMap.end()) {
-				setMap.push_back({ setIndex, {} });
+				it = setMap.insert(setMap.end(), { setIndex, {} });
 			}
 			auto& bindingMap = it->second;
 			
@@ -61,84 +73,416 @@ VkPipelineLayout createLayout(const std::vector<const SpvReflectShaderModule*>&
 					bindingMap.push_back({ 
 						.binding = bindingIndex,
 						.descriptorType = static_cast<VkDescriptorType>(binding->descriptor_type),
-						.descriptorCount = binding->count,
-						.stageFlags = VK_SHADER_STAGE_ALL,
+						.descriptorCount = binding->count == 0 ? bindlessCount : binding->count,
+						.stageFlags = stageFlag,
 					});
+				} else {
+					it->stageFlags |= stageFlag;
 				}
 			}
 		}
+
+		uint32_t blockCount;
+		spvReflectEnumeratePushConstantBlocks(stage, &blockCount, nullptr);
+
+		std::vector<SpvReflectBlockVariable*> blocks(blockCount);
+		spvReflectEnumeratePushConstantBlocks(stage, &blockCount, blocks.data());
+
+		for (const auto* block : blocks) {
+			auto it = std::find_if(ranges.begin(), ranges.end(), [=](const auto& range) { return range.offset == block->offset && range.size == block->size; });
+			if (it == ranges.end()) {
+				ranges.push_back({ stageFlag, block->offset, block->size });
+			} else {
+				it->stageFlags |= stageFlag;
+			}
+		}
 	}
 
+	// set indices are positional in the pipeline layout, unused sets get an empty layout
+	std::sort(setMap.begin(), setMap.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
 	std::vector<VkDescriptorSetLayout> setLayouts;
 	for (uint32_t i = 0; i < setMap.size(); ++i) {
 		uint32_t setIndex = setMap[i].first;
 		auto& bindingMap = setMap[i].second;
 		
-		setLayouts.emplace_back(engine.setLayout(bindingMap));
+		while (setLayouts.size() < setIndex) {
+			setLayouts.emplace_back(engine.setLayout({}));
+			sets.push_back({ setLayouts.back(), {}, false });
+		}
+
+		// runtime sized arrays are bound partially, only the descriptors a draw indexes need to be valid.
+		// they grow while frames using them are in flight, so elements may be written after the set is bound
+		constexpr VkDescriptorBindingFlags bindlessFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		std::vector<VkDescriptorBindingFlags> flags(bindingMap.size(), 0);
+		for (uint32_t j = 0; j < bindingMap.size(); ++j) {
+			if (bindingMap[j].descriptorCount == bindlessCount) {
+				flags[j] = bindlessFlags;
+			}
+		}
+		setLayouts.emplace_back(engine.setLayout(bindingMap, flags));
+
+		bool bindless = std::find(flags.begin(), flags.end(), bindlessFlags) != flags.end();
+		Program::Set& set = sets.emplace_back(Program::Set{ setLayouts.back(), {}, bindless });
+		for (const VkDescriptorSetLayoutBinding& binding : bindingMap) {
+			auto it = std::find_if(set.counts.begin(), set.counts.end(), [&](const auto& count) { return count.first == binding.descriptorType; });
+			if (it == set.counts.end()) {
+				set.counts.emplace_back(binding.descriptorType, binding.descriptorCount);
+			} else {
+				it->second += binding.descriptorCount;
+			}
+		}
 	}
 
-	VkPipelineLayoutCreateInfo info {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-		.setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
-		.pSetLayouts = setLayouts.data(),
+	return engine.pipelineLayout(setLayouts, ranges);
+}
+
+VkShaderModule createModule(const std::vector<uint32_t>& code) {
+	VkShaderModuleCreateInfo info {
+		.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+		.codeSize = code.size() * sizeof(uint32_t),
+		.pCode = code.data()
 	};
 
-	VkPipelineLayout layout;
-	VK_ASSERT(vkCreatePipelineLayout(engine.device, &info, nullptr, &layout));
-	return layout;
+	VkShaderModule module;
+	VK_ASSERT(vkCreateShaderModule(Arawn::engine.device, &info, nullptr, &module));
+	return module;
 }
 
 Arawn::Program::Program(const char* comp) {
-	auto compModule = loadShader(comp);
+	std::vector<uint32_t> compCode;
+	auto compModule = loadShader(comp, compCode);
+
+	layout = createLayout(std::vector<const SpvReflectShaderModule*>{ &compModule }, sets);
 
-	layout = createLayout(std::vector<const SpvReflectShaderModule*>{ &compModule });
+	{ // create compute pipeline through the engine's pipeline cache
+		VkShaderModule module = createModule(compCode);
+
+		VkComputePipelineCreateInfo info {
+			.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+			.stage = {
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+				.module = module,
+				.pName = compModule.entry_point_name
+			},
+			.layout = layout
+		};
+
+		VK_ASSERT(vkCreateComputePipelines(engine.device, engine.pipelineCache, 1, &info, nullptr, &pipeline));
+
+		vkDestroyShaderModule(engine.device, module, nullptr);
+	}
 
 	spvReflectDestroyShaderModule(&compModule);
 }
 
-Arawn::Program::Program(const char* vert, const char* frag) {
-	auto vertModule = loadShader(vert);
-	auto fragModule = loadShader(frag);	
+Arawn::Program::Program(const char* vert, const char* frag) : pipeline(VK_NULL_HANDLE) {
+	std::vector<uint32_t> vertCode, fragCode;
+	auto vertModule = loadShader(vert, vertCode);
+	auto fragModule = loadShader(frag, fragCode);	
+
+	layout = createLayout(std::vector<const SpvReflectShaderModule*>{} = { &vertModule, &fragModule }, sets);
+
+	spvReflectDestroyShaderModule(&vertModule);
+	spvReflectDestroyShaderModule(&fragModule);
+}
+
+Arawn::Program::Program(const char* vert, const char* frag, const Program::Target& target) : pipeline(VK_NULL_HANDLE) {
+	std::vector<uint32_t> vertCode, fragCode;
+	auto vertModule = loadShader(vert, vertCode);
+	auto fragModule = loadShader(frag, fragCode);	
+
+	layout = createLayout(std::vector<const SpvReflectShaderModule*>{} = { &vertModule, &fragModule }, sets);
+
+	// the lighting subpass of a merged pass writes its single sampled colour, depth is only read as an input attachment
+	bool lighting = target.merged != VK_FORMAT_UNDEFINED && target.subpass == 1;
+	VkSampleCountFlagBits samples = lighting ? VK_SAMPLE_COUNT_1_BIT : static_cast<VkSampleCountFlagBits>(target.samples);
+	uint32_t colourCount = lighting ? 1 : static_cast<uint32_t>(target.colour.size());
+	VkFormat depth = lighting ? VK_FORMAT_UNDEFINED : target.depth;
+
+	// pipelines are usable with any render pass compatible with the one they are created against
+	VkRenderPass renderpass = renderPass(target);
+
+	{ // create graphics pipeline through the engine's pipeline cache
+		VkShaderModule vertShader = createModule(vertCode);
+		VkShaderModule fragShader = createModule(fragCode);
+
+		std::array<VkPipelineShaderStageCreateInfo, 2> stages {
+			VkPipelineShaderStageCreateInfo{ .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, .stage = VK_SHADER_STAGE_VERTEX_BIT, .module = vertShader, .pName = vertModule.entry_point_name },
+			VkPipelineShaderStageCreateInfo{ .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, .stage = VK_SHADER_STAGE_FRAGMENT_BIT, .module = fragShader, .pName = fragModule.entry_point_name }
+		};
+
+		// every pipeline reads the one vertex layout, reflection only selects the locations the shader consumes
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		VkVertexInputBindingDescription binding { 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX };
+		{ // reflect vertex inputs
+			uint32_t count;
+			spvReflectEnumerateInputVariables(&vertModule, &count, nullptr);
+			std::vector<SpvReflectInterfaceVariable*> inputs(count);
+			spvReflectEnumerateInputVariables(&vertModule, &count, inputs.data());
+
+			inputs.erase(std::remove_if(inputs.begin(), inputs.end(), [](const auto* input) {
+				return input->decoration_flags & SPV_REFLECT_DECORATION_BUILT_IN;
+			}), inputs.end());
+
+			std::sort(inputs.begin(), inputs.end(), [](const auto* lhs, const auto* rhs) { return lhs->location < rhs->location; });
+
+			constexpr uint32_t offsets[] = {
+				offsetof(Vertex, position), offsetof(Vertex, texcoord), offsetof(Vertex, normal), offsetof(Vertex, tangent), offsetof(Vertex, bi_tangent)
+			};
+
+			for (const auto* input : inputs) {
+				if (input->location >= std::size(offsets)) {
+					throw std::runtime_error("vertex input location is not part of the vertex layout");
+				}
+				attributes.push_back({ input->location, 0, static_cast<VkFormat>(input->format), offsets[input->location] });
+			}
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertexState {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+			.vertexBindingDescriptionCount = attributes.empty() ? 0u : 1u,
+			.pVertexBindingDescriptions = &binding,
+			.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size()),
+			.pVertexAttributeDescriptions = attributes.data()
+		};
+
+		VkPipelineInputAssemblyStateCreateInfo assemblyState {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+			.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST
+		};
+
+		VkPipelineViewportStateCreateInfo viewportState {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+			.viewportCount = 1,
+			.scissorCount = 1
+		};
 
-	layout = createLayout(std::vector<const SpvReflectShaderModule*>{} = { &vertModule, &fragModule });
+		VkPipelineRasterizationStateCreateInfo rasterizerState {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+			.polygonMode = VK_POLYGON_MODE_FILL,
+			.cullMode = attributes.empty() ? static_cast<VkCullModeFlags>(VK_CULL_MODE_NONE) : static_cast<VkCullModeFlags>(VK_CULL_MODE_BACK_BIT), // fullscreen passes
+			.frontFace = VK_FRONT_FACE_CLOCKWISE,
+			.lineWidth = 1.0f
+		};
+
+		VkPipelineMultisampleStateCreateInfo multisampleState {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+			.rasterizationSamples = samples
+		};
+
+		VkPipelineDepthStencilStateCreateInfo depthStencilState {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+			.depthTestEnable = depth != VK_FORMAT_UNDEFINED ? VK_TRUE : VK_FALSE,
+			.depthWriteEnable = depth != VK_FORMAT_UNDEFINED && target.depthWrite ? VK_TRUE : VK_FALSE,
+			.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL
+		};
+
+		std::vector<VkPipelineColorBlendAttachmentState> blendAttachments(colourCount, VkPipelineColorBlendAttachmentState{
+			.blendEnable = VK_FALSE,
+			.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+		});
+
+		VkPipelineColorBlendStateCreateInfo blendState {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+			.logicOp = VK_LOGIC_OP_COPY,
+			.attachmentCount = static_cast<uint32_t>(blendAttachments.size()),
+			.pAttachments = blendAttachments.data()
+		};
+
+		std::array<VkDynamicState, 2> dynamics { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+		VkPipelineDynamicStateCreateInfo dynamicState {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+			.dynamicStateCount = static_cast<uint32_t>(dynamics.size()),
+			.pDynamicStates = dynamics.data()
+		};
+
+		VkGraphicsPipelineCreateInfo info {
+			.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+			.stageCount = static_cast<uint32_t>(stages.size()),
+			.pStages = stages.data(),
+			.pVertexInputState = &vertexState,
+			.pInputAssemblyState = &assemblyState,
+			.pViewportState = &viewportState,
+			.pRasterizationState = &rasterizerState,
+			.pMultisampleState = &multisampleState,
+			.pDepthStencilState = &depthStencilState,
+			.pColorBlendState = &blendState,
+			.pDynamicState = &dynamicState,
+			.layout = layout,
+			.renderPass = renderpass,
+			.subpass = target.merged != VK_FORMAT_UNDEFINED ? target.subpass : 0
+		};
+
+		VK_ASSERT(vkCreateGraphicsPipelines(engine.device, engine.pipelineCache, 1, &info, nullptr, &pipeline));
+
+		vkDestroyShaderModule(engine.device, vertShader, nullptr);
+		vkDestroyShaderModule(engine.device, fragShader, nullptr);
+	}
+
+	vkDestroyRenderPass(engine.device, renderpass, nullptr);
 
 	spvReflectDestroyShaderModule(&vertModule);
 	spvReflectDestroyShaderModule(&fragModule);
 }
 
-Arawn::Program::Program(const char* vert, const char* geom, const char* frag) {
-	auto vertModule = loadShader(vert);
-	auto geomModule = loadShader(geom);	
-	auto fragModule = loadShader(frag);	
+Arawn::Program::Program(const char* vert, const char* geom, const char* frag) : pipeline(VK_NULL_HANDLE) {
+	std::vector<uint32_t> vertCode, geomCode, fragCode;
+	auto vertModule = loadShader(vert, vertCode);
+	auto geomModule = loadShader(geom, geomCode);	
+	auto fragModule = loadShader(frag, fragCode);	
 
-	layout = createLayout(std::vector<const SpvReflectShaderModule*>{} = { &vertModule, &geomModule, &fragModule });
+	layout = createLayout(std::vector<const SpvReflectShaderModule*>{} = { &vertModule, &geomModule, &fragModule }, sets);
 
 	spvReflectDestroyShaderModule(&vertModule);
 	spvReflectDestroyShaderModule(&geomModule);
 	spvReflectDestroyShaderModule(&fragModule);
 }
 
+VkRenderPass Arawn::Program::renderPass(const Target& target) {
+	VkSampleCountFlagBits samples = static_cast<VkSampleCountFlagBits>(target.samples);
+	bool merged = target.merged != VK_FORMAT_UNDEFINED;
+
+	std::vector<VkAttachmentDescription> attachments;
+	std::vector<VkAttachmentReference> colourRefs, resolveRefs, inputRefs;
+	VkAttachmentReference depthRef { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+	VkAttachmentReference lightingRef { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+
+	// load and store ops do not affect compatibility, they only matter for merged passes which are recorded as created.
+	// the merged g-buffer is cleared and never stored, so on tile based gpus it stays in tile memory
+	auto attachment = [&](VkFormat format, VkSampleCountFlagBits samples, VkImageLayout layout, VkAttachmentLoadOp load = VK_ATTACHMENT_LOAD_OP_DONT_CARE, VkAttachmentStoreOp store = VK_ATTACHMENT_STORE_OP_DONT_CARE) {
+		attachments.push_back({
+			.format = format, .samples = samples,
+			.loadOp = load, .storeOp = store,
+			.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE, .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			.initialLayout = load == VK_ATTACHMENT_LOAD_OP_LOAD ? layout : VK_IMAGE_LAYOUT_UNDEFINED, .finalLayout = layout
+		});
+		return VkAttachmentReference{ static_cast<uint32_t>(attachments.size() - 1), layout };
+	};
+
+	VkAttachmentLoadOp gbufferLoad = merged ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	for (VkFormat format : target.colour) {
+		colourRefs.push_back(attachment(format, samples, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, gbufferLoad));
+	}
+
+	if (target.resolve) {
+		for (VkFormat format : target.colour) {
+			resolveRefs.push_back(attachment(format, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+		}
+	}
+
+	if (target.depth != VK_FORMAT_UNDEFINED) {
+		// depth outlives a merged pass, eg for the next frame's depth pyramid
+		VkAttachmentLoadOp load = !merged ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : target.depthWrite ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+		VkAttachmentStoreOp store = merged ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthRef = attachment(target.depth, samples, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, load, store);
+	}
+
+	std::vector<VkSubpassDescription> subpasses {{
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.colorAttachmentCount = static_cast<uint32_t>(colourRefs.size()),
+		.pColorAttachments = colourRefs.data(),
+		.pResolveAttachments = resolveRefs.empty() ? nullptr : resolveRefs.data(),
+		.pDepthStencilAttachment = target.depth != VK_FORMAT_UNDEFINED ? &depthRef : nullptr
+	}};
+
+	std::vector<VkSubpassDependency> dependencies;
+
+	if (merged) { // lighting subpass reads the g-buffer and depth of the same pixel as input attachments
+		lightingRef = attachment(target.merged, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE);
+
+		for (const VkAttachmentReference& ref : colourRefs) {
+			inputRefs.push_back({ ref.attachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+		}
+		if (target.depth != VK_FORMAT_UNDEFINED) {
+			inputRefs.push_back({ depthRef.attachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL });
+		}
+
+		subpasses.push_back({
+			.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+			.inputAttachmentCount = static_cast<uint32_t>(inputRefs.size()),
+			.pInputAttachments = inputRefs.data(),
+			.colorAttachmentCount = 1,
+			.pColorAttachments = &lightingRef
+		});
+
+		dependencies.push_back({
+			.srcSubpass = 0,
+			.dstSubpass = 1,
+			.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+			.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
+		});
+
+		// the g-buffer and depth end the pass in the layout the lighting subpass read them in
+		for (const VkAttachmentReference& ref : inputRefs) {
+			attachments[ref.attachment].finalLayout = ref.layout;
+		}
+	}
+
+	VkRenderPassCreateInfo info {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+		.attachmentCount = static_cast<uint32_t>(attachments.size()),
+		.pAttachments = attachments.data(),
+		.subpassCount = static_cast<uint32_t>(subpasses.size()),
+		.pSubpasses = subpasses.data(),
+		.dependencyCount = static_cast<uint32_t>(dependencies.size()),
+		.pDependencies = dependencies.data()
+	};
+
+	VkRenderPass renderpass;
+	VK_ASSERT(vkCreateRenderPass(engine.device, &info, nullptr, &renderpass));
+	return renderpass;
+}
+
+std::string Arawn::Program::permutation(std::string_view source, const std::vector<std::string_view>& defines) {
+	// the manifest only changes when the build is reconfigured, it is loaded once and kept alive for its views
+	static const std::string manifest = Json::load(SHADER_MANIFEST_PATH);
+	static const Json::Object entries = Json(manifest);
+
+	for (const auto& [spirv, entry] : entries) {
+		if (static_cast<Json::String>(entry["source"]) != source) continue;
+
+		// defines are matched in any order
+		Json::StringBuffer compiled = entry["defines"];
+		if (std::is_permutation(compiled.begin(), compiled.end(), defines.begin(), defines.end())) {
+			return std::string(spirv);
+		}
+	}
+
+	throw std::runtime_error("shader permutation missing from the manifest");
+}
+
+// layouts are owned by the engine's layout cache
 Arawn::Program::~Program() noexcept {
-	vkDestroyPipeline(engine.device, pipeline, nullptr);
-	vkDestroyPipelineLayout(engine.device, layout, nullptr);
+	if (pipeline != nullptr) {
+		vkDestroyPipeline(engine.device, pipeline, nullptr);
+	}
 }
 
 Arawn::Program::Program(Program&& other) noexcept {
 	pipeline = other.pipeline;
 	layout = other.layout;
+	sets = std::move(other.sets);
 
+	other.pipeline = nullptr;
 	other.layout = nullptr;
 }
 
 Arawn::Program& Arawn::Program::operator=(Program&& other) noexcept {
 	if (pipeline != nullptr) {
 		vkDestroyPipeline(engine.device, pipeline, nullptr);
-		vkDestroyPipelineLayout(engine.device, layout, nullptr);
 	}
 	
 	pipeline = other.pipeline;
 	layout = other.layout;
+	sets = std::move(other.sets);
 
+	other.pipeline = nullptr;
 	other.layout = nullptr;
 
 	return *this;
@@ -0,0 +1,367 @@
+#define ARAWN_IMPLEMENTATION
+#include <graphics/resources/staging.h>
+#include <cstring>
+#include <algorithm>
+
+// satisfies buffer to image copy offsets for every texel size
+constexpr uint64_t stagingAlignment = 16;
+
+Arawn::StagingRing::StagingRing(uint64_t capacity)
+ : capacity(capacity), head(0), tail(0), pendingValue(0)
+{
+	{ // create persistently mapped ring
+		VkBufferCreateInfo info {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.size = capacity,
+			.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE
+		};
+
+		VmaAllocationCreateInfo alloc {
+			.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+			.usage = VMA_MEMORY_USAGE_CPU_ONLY
+		};
+
+		VmaAllocationInfo allocInfo;
+		VK_ASSERT(vmaCreateBuffer(engine.allocator, &info, &alloc, &buffer, &memory, &allocInfo));
+		mapped = static_cast<uint8_t*>(allocInfo.pMappedData);
+	}
+
+	{ // create command pool
+		VkCommandPoolCreateInfo info {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+			.queueFamilyIndex = engine.family[TRANSFER]
+		};
+		VK_ASSERT(vkCreateCommandPool(engine.device, &info, nullptr, &pool));
+	}
+}
+
+Arawn::StagingRing::~StagingRing() {
+	if (!submits.empty()) {
+		engine.wait(TRANSFER, submits.back().value);
+	}
+
+	vkDestroyCommandPool(engine.device, pool, nullptr);
+	vmaDestroyBuffer(engine.allocator, buffer, memory);
+}
+
+void Arawn::StagingRing::upload(Buffer& dst, const void* data, uint64_t size, uint64_t offset, QueueType consumer, bool inFlight) {
+	uint64_t src = allocate(size, stagingAlignment);
+	std::memcpy(mapped + src, data, size);
+
+	copies.push_back({ dst.buffer, VK_NULL_HANDLE, src, offset, size, 0, 0, consumer, inFlight });
+}
+
+void Arawn::StagingRing::upload(Image& dst, const void* data, uint64_t size, uint32_t width, uint32_t height, QueueType consumer) {
+	uint64_t src = allocate(size, stagingAlignment);
+	std::memcpy(mapped + src, data, size);
+
+	copies.push_back({ VK_NULL_HANDLE, dst.image, src, 0, size, width, height, consumer, false });
+}
+
+uint64_t Arawn::StagingRing::flush(uint32_t queues) {
+	if (!copies.empty()) {
+		submit();
+	}
+
+	// acquire is only recorded by the first command buffer of each queue, an unmatched release would never be acquired
+	for (const Copy& copy : released) {
+		uint32_t family = engine.family[copy.consumer];
+
+		bool acquired = false;
+		for (uint32_t queue = GRAPHICS; queue <= PRESENT; ++queue) {
+			acquired |= (queues & (1u << queue)) != 0 && engine.family[queue] == family;
+		}
+
+		if (!acquired) {
+			throw std::runtime_error("staged upload released to a queue family without a batch to acquire it");
+		}
+	}
+
+	uint64_t value = pendingValue;
+	pendingValue = 0;
+	return value;
+}
+
+void Arawn::StagingRing::acquire(VkCommandBuffer cmd, QueueType queue) {
+	uint32_t family = engine.family[queue];
+
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+
+	auto it = std::remove_if(released.begin(), released.end(), [&](const Copy& copy) {
+		if (engine.family[copy.consumer] != family) return false;
+
+		if (copy.buffer != VK_NULL_HANDLE) {
+			bufferBarriers.push_back({
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+				.pNext = nullptr,
+				.srcAccessMask = 0,
+				.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+				.srcQueueFamilyIndex = engine.family[TRANSFER],
+				.dstQueueFamilyIndex = family,
+				.buffer = copy.buffer,
+				.offset = copy.dst,
+				.size = copy.size
+			});
+		} else {
+			imageBarriers.push_back({
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+				.pNext = nullptr,
+				.srcAccessMask = 0,
+				.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+				.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				.srcQueueFamilyIndex = engine.family[TRANSFER],
+				.dstQueueFamilyIndex = family,
+				.image = copy.image,
+				.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+			});
+		}
+		return true;
+	});
+	released.erase(it, released.end());
+
+	if (bufferBarriers.empty() && imageBarriers.empty()) return;
+
+	// the consumer waits on the transfer timeline at all commands
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+		0, nullptr,
+		static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+		static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+	);
+}
+
+uint64_t Arawn::StagingRing::allocate(uint64_t size, uint64_t alignment) {
+	if (size > capacity) {
+		throw std::runtime_error("upload exceeds staging ring capacity");
+	}
+
+	while (true) {
+		reclaim();
+
+		// in use range is [tail, head), wrapping around the end of the ring
+		uint64_t offset = (head + alignment - 1) / alignment * alignment;
+		if (head >= tail) {
+			if (offset + size <= capacity) {
+				head = offset + size;
+				return offset;
+			}
+			if (size < tail) {
+				head = size;
+				return 0;
+			}
+		} else if (offset + size < tail) {
+			head = offset + size;
+			return offset;
+		}
+
+		// ring is full, submit what is batched then wait for the oldest submit
+		if (!copies.empty()) {
+			submit();
+		} else {
+			engine.wait(TRANSFER, submits.front().value);
+		}
+	}
+}
+
+void Arawn::StagingRing::reclaim() {
+	uint64_t completed = engine.completed(TRANSFER);
+
+	while (!submits.empty() && submits.front().value <= completed) {
+		tail = submits.front().end;
+		free.push_back(submits.front().cmd);
+		submits.pop_front();
+	}
+
+	if (submits.empty() && copies.empty()) {
+		head = tail = 0;
+	}
+}
+
+void Arawn::StagingRing::submit() {
+	uint32_t family = engine.family[TRANSFER];
+
+	VkCommandBuffer cmd;
+	if (free.empty()) {
+		VkCommandBufferAllocateInfo info {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.commandPool = pool,
+			.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			.commandBufferCount = 1
+		};
+		VK_ASSERT(vkAllocateCommandBuffers(engine.device, &info, &cmd));
+	} else {
+		cmd = free.back();
+		free.pop_back();
+		VK_ASSERT(vkResetCommandBuffer(cmd, 0));
+	}
+
+	{ // begin cmd buffer
+		VkCommandBufferBeginInfo info {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			.pInheritanceInfo = nullptr
+		};
+		VK_ASSERT(vkBeginCommandBuffer(cmd, &info));
+	}
+
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+	{ // transition images to transfer destination
+		for (const Copy& copy : copies) {
+			if (copy.image == VK_NULL_HANDLE) continue;
+
+			imageBarriers.push_back({
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+				.pNext = nullptr,
+				.srcAccessMask = 0,
+				.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+				.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = copy.image,
+				.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+			});
+		}
+
+		if (!imageBarriers.empty()) {
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr, 0, nullptr,
+				static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+			);
+		}
+	}
+
+	{ // record copies, consecutive writes to the same buffer share one command
+		std::vector<VkBufferCopy> regions;
+		for (uint32_t i = 0; i < copies.size(); ++i) {
+			const Copy& copy = copies[i];
+
+			if (copy.buffer != VK_NULL_HANDLE) {
+				regions.push_back({ copy.src, copy.dst, copy.size });
+
+				if (i + 1 == copies.size() || copies[i + 1].buffer != copy.buffer) {
+					vkCmdCopyBuffer(cmd, buffer, copy.buffer, static_cast<uint32_t>(regions.size()), regions.data());
+					regions.clear();
+				}
+			} else {
+				VkBufferImageCopy region {
+					.bufferOffset = copy.src,
+					.bufferRowLength = 0,
+					.bufferImageHeight = 0,
+					.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+					.imageOffset = { 0, 0, 0 },
+					.imageExtent = { copy.width, copy.height, 1 }
+				};
+				vkCmdCopyBufferToImage(cmd, buffer, copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+			}
+		}
+	}
+
+	{ // release ownership to the consuming family, images move to their sampled layout
+		imageBarriers.clear();
+
+		for (const Copy& copy : copies) {
+			uint32_t consumer = engine.family[copy.consumer];
+			bool transfer = consumer != family;
+
+			if (copy.buffer != VK_NULL_HANDLE) {
+				// same family consumers are covered by the timeline semaphore
+				if (!transfer) continue;
+
+				bufferBarriers.push_back({
+					.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+					.pNext = nullptr,
+					.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+					.dstAccessMask = 0,
+					.srcQueueFamilyIndex = family,
+					.dstQueueFamilyIndex = consumer,
+					.buffer = copy.buffer,
+					.offset = copy.dst,
+					.size = copy.size
+				});
+			} else {
+				imageBarriers.push_back({
+					.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+					.pNext = nullptr,
+					.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+					.dstAccessMask = 0,
+					.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					.srcQueueFamilyIndex = transfer ? family : VK_QUEUE_FAMILY_IGNORED,
+					.dstQueueFamilyIndex = transfer ? consumer : VK_QUEUE_FAMILY_IGNORED,
+					.image = copy.image,
+					.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+				});
+			}
+
+			if (transfer) {
+				released.push_back(copy);
+			}
+		}
+
+		if (!bufferBarriers.empty() || !imageBarriers.empty()) {
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				0, nullptr,
+				static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+				static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+			);
+		}
+	}
+
+	VK_ASSERT(vkEndCommandBuffer(cmd));
+
+	uint64_t value = ++engine.value[TRANSFER];
+
+	std::vector<VkSemaphore> waits;
+	std::vector<uint64_t> waitValues;
+	std::vector<VkPipelineStageFlags> waitStages;
+
+	{ // overwrites of ranges in flight wait for the last submit of every queue that may read them, write after read
+		bool inFlight = std::any_of(copies.begin(), copies.end(), [](const Copy& copy) { return copy.inFlight; });
+
+		for (uint32_t queue = GRAPHICS; queue <= ASYNC && inFlight; ++queue) {
+			if (engine.value[queue] == 0) continue;
+
+			waits.push_back(engine.timeline[queue]);
+			waitValues.push_back(engine.value[queue]);
+			waitStages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
+		}
+	}
+
+	{ // submit on the transfer queue, signalling its timeline
+		VkTimelineSemaphoreSubmitInfo timelineInfo {
+			.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size()),
+			.pWaitSemaphoreValues = waitValues.data(),
+			.signalSemaphoreValueCount = 1,
+			.pSignalSemaphoreValues = &value
+		};
+
+		VkSubmitInfo info {
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.pNext = &timelineInfo,
+			.waitSemaphoreCount = static_cast<uint32_t>(waits.size()),
+			.pWaitSemaphores = waits.data(),
+			.pWaitDstStageMask = waitStages.data(),
+			.commandBufferCount = 1,
+			.pCommandBuffers = &cmd,
+			.signalSemaphoreCount = 1,
+			.pSignalSemaphores = &engine.timeline[TRANSFER]
+		};
+
+		VK_ASSERT(vkQueueSubmit(engine.queue[TRANSFER], 1, &info, VK_NULL_HANDLE));
+	}
+
+	submits.push_back({ cmd, head, value });
+	pendingValue = value;
+	copies.clear();
+}